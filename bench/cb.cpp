@@ -0,0 +1,82 @@
+// CB prefix dispatch benchmark, compares the merged 512 entry table with the old two level dispatch.
+// Usage: gb_bench_cb [million instructions]
+#include <chrono>
+#include <memory>
+#include <string>
+
+#include "gb/cpu.hpp"
+#include "gb/cpu_exe.hpp"
+
+using namespace gb;
+
+namespace {
+    /// Flat 64K bus without any side effects
+    struct FlatBus final : CPU::BUS {
+        std::array<byte_t, 0x10000> memory = {};
+
+        gb_func virtual read_byte(word_t address) noexcept->byte_t override { return memory[address]; }
+
+        gb_func virtual write_byte(word_t address, byte_t value) noexcept->void override { memory[address] = value; }
+
+        gb_func virtual waste() noexcept->void override {}
+    };
+
+    /// Bit unpacking loop in the style of graphics decompressors, branches depend on the data so the host can not
+    /// learn the opcode sequence
+    constexpr byte_t program[] = {
+        0x21, 0x00, 0x80,  // C000 LD HL, $8000
+        0x7E,              // C003 LD A, (HL)
+        0x23,              // C004 INC HL
+        0x06, 0x08,        // C005 LD B, 8
+        0xCB, 0x17,        // C007 RL A
+        0x38, 0x04,        // C009 JR C, $C00F
+        0xCB, 0x21,        // C00B SLA C
+        0x18, 0x04,        // C00D JR $C013
+        0xCB, 0x19,        // C00F RR C
+        0xCB, 0xF9,        // C011 SET 7, C
+        0xCB, 0x13,        // C013 RL E
+        0xCB, 0x46,        // C015 BIT 0, (HL)
+        0x28, 0x02,        // C017 JR Z, $C01B
+        0xCB, 0x36,        // C019 SWAP (HL)
+        0x05,              // C01B DEC B
+        0x20, 0xE9,        // C01C JR NZ, $C007
+        0xCB, 0xA4,        // C01E RES 4, H, keeps HL inside $8000 - $8FFF
+        0xC3, 0x03, 0xC0,  // C020 JP $C003
+    };
+
+    gb_func step_two_level(CPU& cpu, CPU::BUS& bus) noexcept->CPU::Status {
+        auto ctx = CPU::CTX{cpu, bus};
+        auto const op = ctx.op_fetch8();
+        return CPU::EXE::table_op1.ops[op](ctx);
+    }
+
+    template <auto STEP>
+    auto measure(char const* name, std::uint64_t count) -> double {
+        auto bus = std::make_unique<FlatBus>();
+        std::copy(std::begin(program), std::end(program), bus->memory.begin() + 0xC000);
+        auto seed = std::uint32_t{0x12345678};
+        for (auto address = 0x8000; address != 0x9000; ++address) {
+            seed ^= seed << 13, seed ^= seed >> 17, seed ^= seed << 5;
+            bus->memory[address] = static_cast<byte_t>(seed);
+        }
+        auto cpu = CPU{};
+        cpu.reg_ip = 0xC000;
+        auto const start = std::chrono::steady_clock::now();
+        for (std::uint64_t i = 0; i != count; ++i) {
+            STEP(cpu, *bus);
+        }
+        auto const seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        auto const mips = static_cast<double>(count) / seconds / 1e6;
+        // Registers are printed so both runs can be seen doing the same work
+        printf("%-10s %8.2f MIPS (A=%02X C=%02X E=%02X)\n", name, mips, cpu.reg_a, cpu.reg_c, cpu.reg_e);
+        return mips;
+    }
+}
+
+int main(int argc, char** argv) {
+    auto const count = static_cast<std::uint64_t>((argc > 1 ? std::stod(argv[1]) : 200.0) * 1e6);
+    auto const two_level = measure<&step_two_level>("two level", count);
+    auto const merged = measure<&CPU::EXE::step>("merged", count);
+    printf("speedup    %8.2fx\n", merged / two_level);
+    return 0;
+}
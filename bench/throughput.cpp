@@ -0,0 +1,249 @@
+// Throughput of many independent machines, for sizing hosts.
+// Runs the same K instances on 1, 2, 4 ... N threads, each for a fixed number of frames, and reports aggregate MIPS,
+// scaling efficiency, CPU utilization, resident memory per instance and last level cache misses when perf_event_open
+// is allowed. Every instance must end in the same state on every thread count, anything else means machines share
+// mutable state. Rows whose efficiency falls off get a guess at the cause, each row is the fastest of R runs.
+// Usage: gb_bench_throughput [--instances K] [--threads N] [--frames F] [--repeat R] [rom ...]
+// Without ROMs every instance runs a generated one that never waits on LY, so no iteration is fast-forwarded.
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iterator>
+#include <latch>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gb/kernels.hpp"
+#include "gb/machine.hpp"
+#include "gb/state.hpp"
+
+using namespace gb;
+
+namespace {
+    /// Adds B into a 256 byte WRAM buffer, then bumps BGP, in a loop that never waits on LY
+    constexpr byte_t program[] = {
+        0x21, 0x00, 0xC0,  // 0150 LD HL, $C000
+        0x06, 0x00,        // 0153 LD B, 0
+        0x7E,              // 0155 LD A, (HL)
+        0x80,              // 0156 ADD A, B
+        0x22,              // 0157 LD (HL+), A
+        0x05,              // 0158 DEC B
+        0x20, 0xFA,        // 0159 JR NZ, $0155
+        0x3C,              // 015B INC A
+        0xE0, 0x47,        // 015C LDH ($47), A
+        0x18, 0xF0,        // 015E JR $0150
+    };
+
+    auto generated_rom() -> std::vector<byte_t> {
+        auto rom = std::vector<byte_t>(0x8000);
+        byte_t const entry[] = {0x00, 0xC3, 0x50, 0x01};
+        std::copy(std::begin(entry), std::end(entry), rom.begin() + 0x100);
+        std::copy(std::begin(program), std::end(program), rom.begin() + 0x150);
+        return rom;
+    }
+
+    /// Resident set of the whole process from /proc
+    auto resident_bytes() -> std::size_t {
+        auto pages = std::size_t{}, resident = std::size_t{};
+        std::ifstream("/proc/self/statm") >> pages >> resident;
+        return resident * static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+    }
+
+    /// Last level cache misses of the calling thread in user space, -1 when the kernel does not allow it
+    auto open_cache_misses() noexcept -> int {
+        auto attr = perf_event_attr{};
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+
+    auto thread_seconds() noexcept -> double {
+        auto now = timespec{};
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+        return static_cast<double>(now.tv_sec) + static_cast<double>(now.tv_nsec) * 1e-9;
+    }
+
+    struct Row final {
+        unsigned threads = {};
+        double seconds = {};
+        double cpu_seconds = {};
+        std::uint64_t instructions = {};
+        /// Negative when not counted
+        double cache_misses = -1;
+        std::size_t resident = {};
+        /// State hash of every instance after the run
+        std::vector<std::uint64_t> hashes = {};
+    };
+
+    /// Instance i runs roms[i % size] on thread i % threads, machines are built by the thread that runs them so
+    /// their pages are first touched there
+    auto measure(std::vector<std::vector<byte_t>> const& roms, unsigned instances, unsigned threads,
+                 std::uint64_t cycles) -> Row {
+        auto row = Row{.threads = threads, .hashes = std::vector<std::uint64_t>(instances)};
+        auto cpu_seconds = std::vector<double>(threads);
+        auto instructions = std::vector<std::uint64_t>(threads);
+        auto misses = std::vector<long long>(threads, -1);
+        auto ready = std::latch(threads);
+        auto go = std::latch(1);
+        auto done = std::latch(threads);
+        auto finish = std::latch(1);
+        auto const resident = resident_bytes();
+        auto workers = std::vector<std::thread>{};
+        for (auto t = 0u; t != threads; ++t) {
+            workers.emplace_back([&, t] {
+                auto machines = std::vector<std::unique_ptr<Machine>>{};
+                for (auto i = t; i < instances; i += threads) {
+                    auto const& rom = roms[i % roms.size()];
+                    machines.push_back(std::make_unique<Machine>());
+                    machines.back()->load(rom.data(), rom.size());
+                }
+                auto const counter = open_cache_misses();
+                ready.count_down();
+                go.wait();
+                auto const start = thread_seconds();
+                if (counter >= 0) {
+                    ioctl(counter, PERF_EVENT_IOC_ENABLE, 0);
+                }
+                for (auto& machine : machines) {
+                    machine->run(cycles);
+                }
+                cpu_seconds[t] = thread_seconds() - start;
+                if (counter >= 0) {
+                    ioctl(counter, PERF_EVENT_IOC_DISABLE, 0);
+                    if (auto count = std::uint64_t{}; read(counter, &count, sizeof(count)) == sizeof(count)) {
+                        misses[t] = static_cast<long long>(count);
+                    }
+                    close(counter);
+                }
+                for (auto i = t, j = 0u; i < instances; i += threads, ++j) {
+                    auto const& machine = *machines[j];
+                    instructions[t] += machine.mem.metrics.instructions;
+                    auto state = std::vector<byte_t>(State::size(machine.cpu, machine.mem));
+                    state.resize(State::save(machine.cpu, machine.mem, state.data(), state.size()));
+                    row.hashes[i] = Kernels::best().hash(state.data(), state.size(), 0);
+                }
+                done.count_down();
+                finish.wait();
+            });
+        }
+        ready.wait();
+        auto const start = std::chrono::steady_clock::now();
+        go.count_down();
+        done.wait();
+        row.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        row.resident = resident_bytes() - std::min(resident, resident_bytes());
+        finish.count_down();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        for (auto t = 0u; t != threads; ++t) {
+            row.cpu_seconds += cpu_seconds[t];
+            row.instructions += instructions[t];
+        }
+        if (std::none_of(misses.begin(), misses.end(), [](auto count) { return count < 0; })) {
+            row.cache_misses = 0;
+            for (auto const count : misses) {
+                row.cache_misses += static_cast<double>(count);
+            }
+        }
+        return row;
+    }
+}
+
+int main(int argc, char** argv) {
+    auto const cores = std::max(std::thread::hardware_concurrency(), 1u);
+    auto instances = cores * 2;
+    auto max_threads = cores;
+    auto frames = 60ll;
+    auto repeat = 3;
+    auto roms = std::vector<std::vector<byte_t>>{};
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--instances") && i + 1 < argc) {
+            instances = static_cast<unsigned>(std::max(std::stoi(argv[++i]), 1));
+        } else if (!strcmp(argv[i], "--threads") && i + 1 < argc) {
+            max_threads = static_cast<unsigned>(std::max(std::stoi(argv[++i]), 1));
+        } else if (!strcmp(argv[i], "--frames") && i + 1 < argc) {
+            frames = std::max(std::stoll(argv[++i]), 1ll);
+        } else if (!strcmp(argv[i], "--repeat") && i + 1 < argc) {
+            repeat = std::max(std::stoi(argv[++i]), 1);
+        } else {
+            auto file = std::ifstream(argv[i], std::ios::binary);
+            roms.emplace_back(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>{});
+            if (!file.eof() && !file) {
+                printf("Failed to read %s\n", argv[i]);
+                return 1;
+            }
+        }
+    }
+    if (roms.empty()) {
+        roms.push_back(generated_rom());
+    }
+
+    auto counts = std::vector<unsigned>{};
+    for (auto threads = 1u; threads < max_threads; threads *= 2) {
+        counts.push_back(threads);
+    }
+    counts.push_back(max_threads);
+
+    printf("%u instances of %zu ROM(s), %lld frames each, %u hardware threads\n", instances, roms.size(), frames,
+           cores);
+    printf("threads  seconds     MIPS  speedup  efficiency  cpu use  KiB/instance  LLC miss/kinstr\n");
+    auto const cycles = static_cast<std::uint64_t>(frames) * frame_cycles;
+    auto rows = std::vector<Row>{};
+    auto shared = false;
+    for (auto const threads : counts) {
+        auto& row = rows.emplace_back(measure(roms, instances, threads, cycles));
+        for (auto i = 1; i < repeat; ++i) {
+            auto again = measure(roms, instances, threads, cycles);
+            shared |= again.hashes != row.hashes;
+            if (again.seconds < row.seconds) {
+                row = std::move(again);
+            }
+        }
+        auto const& first = rows.front();
+        auto const mips = static_cast<double>(row.instructions) / row.seconds / 1e6;
+        auto const speedup = first.seconds / row.seconds;
+        // Fewer instances than threads leave some threads idle
+        auto const efficiency = speedup / std::min(threads, instances);
+        auto const use = row.cpu_seconds / (row.seconds * std::min(threads, instances));
+        auto const per_kinstr = [](Row const& r) {
+            return r.cache_misses * 1e3 / static_cast<double>(std::max(r.instructions, std::uint64_t{1}));
+        };
+        char misses[24] = "n/a";
+        if (row.cache_misses >= 0) {
+            snprintf(misses, sizeof(misses), "%.3f", per_kinstr(row));
+        }
+        printf("%7u  %7.3f  %7.1f  %7.2f  %10.2f  %7.2f  %12zu  %15s\n", threads, row.seconds, mips, speedup,
+               efficiency, use, row.resident / instances / 1024, misses);
+
+        if (shared || row.hashes != first.hashes) {
+            printf("         instances ended in different states than on one thread, machines share mutable state\n");
+            shared = true;
+        }
+        if (threads > cores) {
+            printf("         more threads than hardware threads, scaling can not hold\n");
+        } else if (efficiency < 0.85 && use < 0.9) {
+            printf("         threads are waiting off the CPU, look for lock or allocator contention\n");
+        } else if (efficiency < 0.85 && row.cache_misses >= 0 && first.cache_misses >= 0 &&
+                   per_kinstr(row) > 2 * per_kinstr(first) + 0.01) {
+            printf("         cache misses per instruction grew, look for false sharing or a working set past LLC\n");
+        } else if (efficiency < 0.85) {
+            printf("         instructions got slower on busy CPUs, look for false sharing, SMT or clock drops\n");
+        }
+    }
+    return shared ? 1 : 0;
+}
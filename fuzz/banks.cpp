@@ -0,0 +1,110 @@
+// MBC1 fuzzer, random register writes against a model of the chip as documented rather than of MCB1: BANK1, BANK2 and
+// the mode are kept as the separate registers they are and the address of every read is worked out from them.
+// Input: 3 byte records. The top two bits of the first byte pick the operation, the rest of it and the second byte
+// the address and the third byte the value: 0 writes an MBC register in 0x0000 - 0x7FFF, 1 writes ERAM, 2 reads ROM
+// in 0x0000 - 0x7FFF and 3 reads ERAM. Every read is checked against the model and against the DMA view of the bus.
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <tuple>
+
+#include "gb/mcb1.hpp"
+
+using namespace gb;
+
+namespace {
+    /// Contents of ROM, different in every byte of every bank so a read tells which bank it came from
+    constexpr auto rom_byte(std::size_t offset) -> byte_t {
+        return static_cast<byte_t>((offset * 0x9E3779B1u) >> 24 ^ offset >> 14);
+    }
+
+    struct Model {
+        bool enable = {};
+        bool mode = {};
+        /// 5 bit ROM bank, a written 0 selects 1
+        unsigned bank1 = 1;
+        /// 2 bit upper ROM bank or ERAM bank, what it applies to depends on the mode
+        unsigned bank2 = {};
+        std::array<byte_t, 0x8000> eram = {};
+
+        auto write(word_t address, byte_t value) -> void {
+            if (address < 0x2000) {
+                enable = (value & 0xF) == 0xA;
+            } else if (address < 0x4000) {
+                bank1 = value & 0x1F ? value & 0x1F : 1;
+            } else if (address < 0x6000) {
+                bank2 = value & 3;
+            } else {
+                mode = value & 1;
+            }
+        }
+
+        /// Mode 1 maps bank BANK2 << 5 at 0x0000, 0x4000 always sees BANK2 << 5 | BANK1
+        auto rom(word_t address) const -> byte_t {
+            auto const bank = address < 0x4000 ? (mode ? bank2 << 5 : 0) : (bank2 << 5 | bank1);
+            return rom_byte((bank * 0x4000 + (address & 0x3FFF)) % 0x140000);
+        }
+
+        auto eram_offset(word_t address) const -> std::size_t {
+            return (mode ? bank2 : 0) * 0x2000 + (address & 0x1FFF);
+        }
+    };
+
+    auto check(char const* what, word_t address, byte_t actual, byte_t expected) -> void {
+        if (actual != expected) {
+            fprintf(stderr, "%s at %04X read %02X, expected %02X\n", what, address, actual, expected);
+            abort();
+        }
+    }
+}
+
+extern "C" int LLVMFuzzerTestOneInput(std::uint8_t const* data, std::size_t size) {
+    // Filling ROM is the expensive part, between inputs only the banking state goes back to power on
+    static auto const mem = [] {
+        auto mem = std::make_unique<CPU::MCB1>();
+        for (auto i = std::size_t{}; i != mem->ROM.size(); ++i) {
+            mem->ROM[i] = rom_byte(i);
+        }
+        return mem;
+    }();
+    static auto const power_on = std::tuple{mem->eram_enable, mem->mode, mem->rom_bank};
+    std::tie(mem->eram_enable, mem->mode, mem->rom_bank) = power_on;
+    mem->ERAM = {};
+    mem->remap();
+
+    auto model = Model{};
+    for (; size >= 3; data += 3, size -= 3) {
+        auto const value = data[2];
+        auto address = static_cast<word_t>((data[0] & 0x3F) << 8 | data[1]);
+        switch (data[0] >> 6) {
+            case 0:
+                address = static_cast<word_t>(address << 1 & 0x7FFF);
+                mem->write_byte(address, value);
+                model.write(address, value);
+                break;
+            case 1:
+                address = static_cast<word_t>(0xA000 | (address & 0x1FFF));
+                mem->write_byte(address, value);
+                if (model.enable) {
+                    model.eram[model.eram_offset(address)] = value;
+                }
+                break;
+            case 2: {
+                // The value byte gives the lowest address bit
+                address = static_cast<word_t>(address << 1 | (value & 1));
+                auto const expected = model.rom(address);
+                check("ROM", address, mem->read_byte(address), expected);
+                check("ROM through DMA", address, mem->peek(address), expected);
+                break;
+            }
+            default: {
+                address = static_cast<word_t>(0xA000 | (address & 0x1FFF));
+                auto const expected = model.enable ? model.eram[model.eram_offset(address)] : byte_t{0xFF};
+                check("ERAM", address, mem->read_byte(address), expected);
+                check("ERAM through DMA", address, mem->peek(address), expected);
+                break;
+            }
+        }
+    }
+    return 0;
+}
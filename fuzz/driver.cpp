@@ -0,0 +1,55 @@
+// Stand-in for libFuzzer where the compiler has none.
+// Replays every file named on the command line, like libFuzzer does with a crash reproducer, or with -runs=N feeds N
+// random inputs of up to -max_len=L bytes from -seed=S, enough for ctest to smoke test a harness.
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+extern "C" int LLVMFuzzerTestOneInput(std::uint8_t const* data, std::size_t size);
+
+int main(int argc, char** argv) {
+    auto runs = 0ull;
+    auto max_len = std::size_t{4096};
+    auto seed = std::uint64_t{1};
+    auto files = std::vector<char const*>{};
+    for (int i = 1; i < argc; ++i) {
+        if (!strncmp(argv[i], "-runs=", 6)) {
+            runs = std::stoull(argv[i] + 6);
+        } else if (!strncmp(argv[i], "-max_len=", 9)) {
+            max_len = std::stoull(argv[i] + 9);
+        } else if (!strncmp(argv[i], "-seed=", 6)) {
+            seed = std::stoull(argv[i] + 6);
+        } else {
+            files.push_back(argv[i]);
+        }
+    }
+
+    for (auto const filename : files) {
+        auto file = std::ifstream(filename, std::ios::binary);
+        if (!file) {
+            fprintf(stderr, "Failed to open %s\n", filename);
+            return 1;
+        }
+        auto const input = std::vector<std::uint8_t>(std::istreambuf_iterator<char>(file), {});
+        LLVMFuzzerTestOneInput(input.data(), input.size());
+    }
+
+    // Sizes are skewed towards short inputs, where most of the interesting control flow of every harness lives
+    auto rng = std::mt19937_64(seed);
+    auto input = std::vector<std::uint8_t>{};
+    for (auto run = 0ull; run != runs; ++run) {
+        auto const limit = std::size_t{1} << std::uniform_int_distribution<int>(0, 62)(rng) % 13;
+        input.resize(std::uniform_int_distribution<std::size_t>(0, std::min(limit, max_len))(rng));
+        for (auto& byte : input) {
+            byte = static_cast<std::uint8_t>(rng());
+        }
+        LLVMFuzzerTestOneInput(input.data(), input.size());
+    }
+    printf("%zu files, %llu random inputs\n", files.size(), runs);
+    return 0;
+}
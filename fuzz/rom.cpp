@@ -0,0 +1,25 @@
+// Whole machine fuzzer, the input is a cartridge run for a few frames.
+// Inputs shorter than a cartridge header are taken as an instruction stream at the entry point instead, so the
+// fuzzer reaches interesting code without first having to discover the jump at 0x100.
+#include <memory>
+
+#include "gb/machine.hpp"
+
+using namespace gb;
+
+namespace {
+    constexpr std::uint64_t budget = 4 * frame_cycles;
+    constexpr std::size_t header_end = 0x150;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(std::uint8_t const* data, std::size_t size) {
+    auto const machine = std::make_unique<Machine>();
+    if (size < header_end) {
+        std::copy_n(data, size, machine->mem.ROM.begin() + 0x100);
+        Boot::start(machine->cpu, machine->mem);
+    } else if (!machine->load(data, size)) {
+        return 0;
+    }
+    machine->run(budget);
+    return 0;
+}
@@ -0,0 +1,450 @@
+// Differential fuzzer, EXE::step against a deliberately simple reference interpreter.
+// Input: 12 bytes of registers (A F B C D E H L SPlo SPhi PClo PChi), one byte whose low bit is IME, then an
+// instruction stream placed at PC. The rest of memory is filled from a generator seeded by the registers.
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+
+#include "gb/cpu_flat.hpp"
+
+using namespace gb;
+
+namespace {
+    constexpr int max_steps = 64;
+    constexpr std::size_t header_size = 13;
+
+    /// SM83 written straight from the opcode map with one switch over the x/y/z fields of the opcode, it shares no
+    /// code with EXE. Conventions match EXE where the hardware leaves room: HALT and STOP end with their status, STOP
+    /// consumes its operand byte, EI takes effect at once and unused opcodes report BAD after the opcode fetch.
+    struct Reference {
+        enum : byte_t { FZ = 0x80, FN = 0x40, FH = 0x20, FC = 0x10 };
+
+        byte_t r[8] = {};  // B C D E H L - A, index 6 is (HL)
+        byte_t f = {};
+        word_t sp = {};
+        word_t pc = {};
+        bool ime = {};
+        std::array<byte_t, 0x10000> memory = {};
+
+        auto read(word_t address) -> byte_t { return memory[address]; }
+        auto write(word_t address, byte_t value) -> void { memory[address] = value; }
+        auto fetch() -> byte_t { return read(pc++); }
+        auto fetch16() -> word_t {
+            auto const lo = fetch();
+            return static_cast<word_t>(lo | fetch() << 8);
+        }
+
+        auto hl() const -> word_t { return static_cast<word_t>(r[4] << 8 | r[5]); }
+        auto set_hl(word_t value) -> void {
+            r[4] = static_cast<byte_t>(value >> 8);
+            r[5] = static_cast<byte_t>(value);
+        }
+
+        auto get8(int code) -> byte_t { return code == 6 ? read(hl()) : r[code]; }
+        auto set8(int code, byte_t value) -> void {
+            if (code == 6) {
+                write(hl(), value);
+            } else {
+                r[code] = value;
+            }
+        }
+
+        /// BC DE HL SP, or AF in place of SP for push and pop
+        auto get16(int p, bool af) -> word_t {
+            switch (p) {
+                case 0: return static_cast<word_t>(r[0] << 8 | r[1]);
+                case 1: return static_cast<word_t>(r[2] << 8 | r[3]);
+                case 2: return hl();
+                default: return af ? static_cast<word_t>(r[7] << 8 | f) : sp;
+            }
+        }
+        auto set16(int p, bool af, word_t value) -> void {
+            auto const hi = static_cast<byte_t>(value >> 8);
+            auto const lo = static_cast<byte_t>(value);
+            switch (p) {
+                case 0: r[0] = hi, r[1] = lo; break;
+                case 1: r[2] = hi, r[3] = lo; break;
+                case 2: r[4] = hi, r[5] = lo; break;
+                default:
+                    if (af) {
+                        r[7] = hi, f = lo & 0xF0;
+                    } else {
+                        sp = value;
+                    }
+            }
+        }
+
+        auto push(word_t value) -> void {
+            write(--sp, static_cast<byte_t>(value >> 8));
+            write(--sp, static_cast<byte_t>(value));
+        }
+        auto pop() -> word_t {
+            auto const lo = read(sp++);
+            return static_cast<word_t>(lo | read(sp++) << 8);
+        }
+
+        auto flag(byte_t mask, bool on) -> void { f = static_cast<byte_t>(on ? f | mask : f & ~mask); }
+        auto condition(int cc) const -> bool {
+            switch (cc) {
+                case 0: return !(f & FZ);
+                case 1: return f & FZ;
+                case 2: return !(f & FC);
+                default: return f & FC;
+            }
+        }
+
+        auto alu(int op, byte_t value) -> void {
+            auto const a = r[7];
+            auto const carry = (op == 1 || op == 3) && (f & FC) ? 1 : 0;
+            auto result = 0;
+            switch (op) {
+                case 0:
+                case 1:
+                    result = a + value + carry;
+                    f = 0;
+                    flag(FH, (a & 0xF) + (value & 0xF) + carry > 0xF);
+                    flag(FC, result > 0xFF);
+                    break;
+                case 2:
+                case 3:
+                case 7:
+                    result = a - value - carry;
+                    f = FN;
+                    flag(FH, (a & 0xF) < (value & 0xF) + carry);
+                    flag(FC, a < value + carry);
+                    break;
+                case 4: result = a & value, f = FH; break;
+                case 5: result = a ^ value, f = 0; break;
+                default: result = a | value, f = 0; break;
+            }
+            flag(FZ, static_cast<byte_t>(result) == 0);
+            if (op != 7) {
+                r[7] = static_cast<byte_t>(result);
+            }
+        }
+
+        /// RLC RRC RL RR SLA SRA SWAP SRL
+        auto rotate(int op, byte_t value) -> byte_t {
+            auto const old_carry = (f & FC) ? 1 : 0;
+            auto result = 0;
+            auto carry = false;
+            switch (op) {
+                case 0: result = value << 1 | value >> 7, carry = value & 0x80; break;
+                case 1: result = value >> 1 | value << 7, carry = value & 1; break;
+                case 2: result = value << 1 | old_carry, carry = value & 0x80; break;
+                case 3: result = value >> 1 | old_carry << 7, carry = value & 1; break;
+                case 4: result = value << 1, carry = value & 0x80; break;
+                case 5: result = (value >> 1) | (value & 0x80), carry = value & 1; break;
+                case 6: result = value >> 4 | value << 4; break;
+                default: result = value >> 1, carry = value & 1; break;
+            }
+            f = 0;
+            flag(FC, carry);
+            flag(FZ, static_cast<byte_t>(result) == 0);
+            return static_cast<byte_t>(result);
+        }
+
+        auto add_sp(byte_t offset) -> word_t {
+            f = 0;
+            flag(FH, (sp & 0xF) + (offset & 0xF) > 0xF);
+            flag(FC, (sp & 0xFF) + offset > 0xFF);
+            return static_cast<word_t>(sp + static_cast<sbyte_t>(offset));
+        }
+
+        auto prefixed() -> CPU::Status {
+            auto const op = fetch();
+            auto const x = op >> 6, y = (op >> 3) & 7, z = op & 7;
+            auto const value = get8(z);
+            if (x == 0) {
+                set8(z, rotate(y, value));
+            } else if (x == 1) {
+                flag(FZ, !((value >> y) & 1));
+                flag(FN, false);
+                flag(FH, true);
+            } else if (x == 2) {
+                set8(z, static_cast<byte_t>(value & ~(1 << y)));
+            } else {
+                set8(z, static_cast<byte_t>(value | 1 << y));
+            }
+            return CPU::Status::OK;
+        }
+
+        auto step() -> CPU::Status {
+            auto const op = fetch();
+            auto const x = op >> 6, y = (op >> 3) & 7, z = op & 7, p = y >> 1, q = y & 1;
+            if (x == 1) {
+                if (y == 6 && z == 6) {
+                    return CPU::Status::HALT;
+                }
+                set8(y, get8(z));
+                return CPU::Status::OK;
+            }
+            if (x == 2) {
+                alu(y, get8(z));
+                return CPU::Status::OK;
+            }
+            if (x == 0) {
+                switch (z) {
+                    case 0:
+                        if (y == 0) {
+                            return CPU::Status::OK;
+                        } else if (y == 1) {
+                            auto const address = fetch16();
+                            write(address, static_cast<byte_t>(sp));
+                            write(static_cast<word_t>(address + 1), static_cast<byte_t>(sp >> 8));
+                        } else if (y == 2) {
+                            fetch();
+                            return CPU::Status::STOP;
+                        } else {
+                            auto const offset = static_cast<sbyte_t>(fetch());
+                            if (y == 3 || condition(y - 4)) {
+                                pc = static_cast<word_t>(pc + offset);
+                            }
+                        }
+                        return CPU::Status::OK;
+                    case 1:
+                        if (!q) {
+                            set16(p, false, fetch16());
+                        } else {
+                            auto const lhs = hl(), rhs = get16(p, false);
+                            flag(FN, false);
+                            flag(FH, (lhs & 0xFFF) + (rhs & 0xFFF) > 0xFFF);
+                            flag(FC, lhs + rhs > 0xFFFF);
+                            set_hl(static_cast<word_t>(lhs + rhs));
+                        }
+                        return CPU::Status::OK;
+                    case 2: {
+                        auto const address = p == 0 ? get16(0, false) : p == 1 ? get16(1, false) : hl();
+                        if (!q) {
+                            write(address, r[7]);
+                        } else {
+                            r[7] = read(address);
+                        }
+                        if (p == 2) {
+                            set_hl(static_cast<word_t>(address + 1));
+                        } else if (p == 3) {
+                            set_hl(static_cast<word_t>(address - 1));
+                        }
+                        return CPU::Status::OK;
+                    }
+                    case 3:
+                        set16(p, false, static_cast<word_t>(get16(p, false) + (q ? -1 : 1)));
+                        return CPU::Status::OK;
+                    case 4:
+                    case 5: {
+                        auto const value = get8(y);
+                        auto const result = static_cast<byte_t>(z == 4 ? value + 1 : value - 1);
+                        set8(y, result);
+                        flag(FZ, result == 0);
+                        flag(FN, z == 5);
+                        flag(FH, z == 4 ? (value & 0xF) == 0xF : (value & 0xF) == 0);
+                        return CPU::Status::OK;
+                    }
+                    case 6:
+                        set8(y, fetch());
+                        return CPU::Status::OK;
+                    default:
+                        break;
+                }
+                auto& a = r[7];
+                switch (y) {
+                    case 0:
+                    case 1:
+                    case 2:
+                    case 3:
+                        a = rotate(y, a);
+                        flag(FZ, false);
+                        break;
+                    case 4:
+                        if (!(f & FN)) {
+                            if ((f & FC) || a > 0x99) {
+                                a = static_cast<byte_t>(a + 0x60);
+                                flag(FC, true);
+                            }
+                            if ((f & FH) || (a & 0xF) > 9) {
+                                a = static_cast<byte_t>(a + 0x06);
+                            }
+                        } else {
+                            if (f & FC) {
+                                a = static_cast<byte_t>(a - 0x60);
+                            }
+                            if (f & FH) {
+                                a = static_cast<byte_t>(a - 0x06);
+                            }
+                        }
+                        flag(FZ, a == 0);
+                        flag(FH, false);
+                        break;
+                    case 5:
+                        a = static_cast<byte_t>(~a);
+                        flag(FN, true);
+                        flag(FH, true);
+                        break;
+                    default:
+                        flag(FC, y == 6 ? true : !(f & FC));
+                        flag(FN, false);
+                        flag(FH, false);
+                        break;
+                }
+                return CPU::Status::OK;
+            }
+            switch (z) {
+                case 0:
+                    if (y < 4) {
+                        if (condition(y)) {
+                            pc = pop();
+                        }
+                    } else if (y == 4) {
+                        write(static_cast<word_t>(0xFF00 + fetch()), r[7]);
+                    } else if (y == 6) {
+                        r[7] = read(static_cast<word_t>(0xFF00 + fetch()));
+                    } else {
+                        auto const result = add_sp(fetch());
+                        if (y == 5) {
+                            sp = result;
+                        } else {
+                            set_hl(result);
+                        }
+                    }
+                    return CPU::Status::OK;
+                case 1:
+                    if (!q) {
+                        set16(p, true, pop());
+                    } else if (p == 0 || p == 1) {
+                        ime = ime || p == 1;
+                        pc = pop();
+                    } else if (p == 2) {
+                        pc = hl();
+                    } else {
+                        sp = hl();
+                    }
+                    return CPU::Status::OK;
+                case 2:
+                    if (y < 4) {
+                        auto const address = fetch16();
+                        if (condition(y)) {
+                            pc = address;
+                        }
+                    } else {
+                        auto const address = y == 4 || y == 6 ? static_cast<word_t>(0xFF00 + r[1]) : fetch16();
+                        if (y == 4 || y == 5) {
+                            write(address, r[7]);
+                        } else {
+                            r[7] = read(address);
+                        }
+                    }
+                    return CPU::Status::OK;
+                case 3:
+                    if (y == 0) {
+                        pc = fetch16();
+                    } else if (y == 1) {
+                        return prefixed();
+                    } else if (y == 6 || y == 7) {
+                        ime = y == 7;
+                    } else {
+                        return CPU::Status::BAD;
+                    }
+                    return CPU::Status::OK;
+                case 4:
+                    if (y < 4) {
+                        auto const address = fetch16();
+                        if (condition(y)) {
+                            push(pc);
+                            pc = address;
+                        }
+                        return CPU::Status::OK;
+                    }
+                    return CPU::Status::BAD;
+                case 5:
+                    if (!q) {
+                        push(get16(p, true));
+                    } else if (p == 0) {
+                        auto const address = fetch16();
+                        push(pc);
+                        pc = address;
+                    } else {
+                        return CPU::Status::BAD;
+                    }
+                    return CPU::Status::OK;
+                case 6:
+                    alu(y, fetch());
+                    return CPU::Status::OK;
+                default:
+                    push(pc);
+                    pc = static_cast<word_t>(y * 8);
+                    return CPU::Status::OK;
+            }
+        }
+    };
+
+    auto report(char const* what, int step, CPU const& cpu, Reference const& ref) -> void {
+        fprintf(stderr, "divergence in %s after step %d\n", what, step);
+        fprintf(stderr, "exe A:%02X F:%02X B:%02X C:%02X D:%02X E:%02X H:%02X L:%02X SP:%04X PC:%04X IME:%d\n",
+                cpu.reg_a, cpu.reg_f.into_byte(), cpu.reg_b, cpu.reg_c, cpu.reg_d, cpu.reg_e, cpu.reg_h, cpu.reg_l,
+                cpu.reg_sp, cpu.reg_ip, cpu.reg_ime);
+        fprintf(stderr, "ref A:%02X F:%02X B:%02X C:%02X D:%02X E:%02X H:%02X L:%02X SP:%04X PC:%04X IME:%d\n",
+                ref.r[7], ref.f, ref.r[0], ref.r[1], ref.r[2], ref.r[3], ref.r[4], ref.r[5], ref.sp, ref.pc, ref.ime);
+        abort();
+    }
+
+    auto same(CPU const& cpu, Reference const& ref) -> bool {
+        return cpu.reg_a == ref.r[7] && cpu.reg_f.into_byte() == ref.f && cpu.reg_b == ref.r[0] &&
+               cpu.reg_c == ref.r[1] && cpu.reg_d == ref.r[2] && cpu.reg_e == ref.r[3] && cpu.reg_h == ref.r[4] &&
+               cpu.reg_l == ref.r[5] && cpu.reg_sp == ref.sp && cpu.reg_ip == ref.pc && cpu.reg_ime == ref.ime;
+    }
+}
+
+extern "C" int LLVMFuzzerTestOneInput(std::uint8_t const* data, std::size_t size) {
+    if (size < header_size) {
+        return 0;
+    }
+    // Both machines are large, keep them around between inputs
+    static auto const flat = std::make_unique<CPU::FLAT>();
+    static auto const ref = std::make_unique<Reference>();
+
+    auto seed = std::uint64_t{0x9E3779B97F4A7C15};
+    for (auto i = std::size_t{}; i != header_size; ++i) {
+        seed = (seed ^ data[i]) * 0x100000001B3;
+    }
+    for (auto& cell : ref->memory) {
+        seed ^= seed << 13, seed ^= seed >> 7, seed ^= seed << 17;
+        cell = static_cast<byte_t>(seed);
+    }
+    ref->r[7] = data[0], ref->f = data[1] & 0xF0;
+    ref->r[0] = data[2], ref->r[1] = data[3], ref->r[2] = data[4], ref->r[3] = data[5];
+    ref->r[4] = data[6], ref->r[5] = data[7];
+    ref->sp = static_cast<word_t>(data[8] | data[9] << 8);
+    ref->pc = static_cast<word_t>(data[10] | data[11] << 8);
+    ref->ime = data[12] & 1;
+    for (auto i = header_size; i != size; ++i) {
+        ref->memory[static_cast<word_t>(ref->pc + (i - header_size))] = data[i];
+    }
+
+    flat->memory = ref->memory;
+    flat->status = CPU::Status::OK;
+    auto& cpu = flat->cpu;
+    cpu = CPU{};
+    cpu.reg_a = ref->r[7], cpu.reg_f = CPU::Flags::from_byte(ref->f);
+    cpu.reg_b = ref->r[0], cpu.reg_c = ref->r[1], cpu.reg_d = ref->r[2], cpu.reg_e = ref->r[3];
+    cpu.reg_h = ref->r[4], cpu.reg_l = ref->r[5];
+    cpu.reg_sp = ref->sp, cpu.reg_ip = ref->pc, cpu.reg_ime = ref->ime;
+
+    for (auto step = 0; step != max_steps; ++step) {
+        auto const expected = ref->step();
+        auto const actual = CPU::EXE::step(cpu, *flat);
+        if (actual != expected) {
+            report("status", step, cpu, *ref);
+        }
+        if (!same(cpu, *ref)) {
+            report("registers", step, cpu, *ref);
+        }
+        if (flat->memory != ref->memory) {
+            report("memory", step, cpu, *ref);
+        }
+        if (expected != CPU::Status::OK) {
+            break;
+        }
+    }
+    return 0;
+}
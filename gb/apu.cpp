@@ -0,0 +1,393 @@
+#include "apu.hpp"
+
+#include <algorithm>
+
+using namespace gb;
+
+namespace {
+    constexpr byte_t duty_table[4] = {0b0000'0001, 0b1000'0001, 0b1000'0111, 0b0111'1110};
+
+    constexpr std::uint32_t noise_divisor[8] = {8, 16, 32, 48, 64, 80, 96, 112};
+
+    // Bits that always read back as 1 for 0xFF10 - 0xFF2F
+    constexpr byte_t read_mask[0x20] = {
+        0x80, 0x3F, 0x00, 0xFF, 0xBF,  // NR10 - NR14
+        0xFF, 0x3F, 0x00, 0xFF, 0xBF,  // NR20 - NR24
+        0x7F, 0xFF, 0x9F, 0xFF, 0xBF,  // NR30 - NR34
+        0xFF, 0xFF, 0x00, 0x00, 0xBF,  // NR40 - NR44
+        0x00, 0x00, 0x70,              // NR50 - NR52
+        0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    };
+
+    template <typename T>
+    auto clock_length(T& ch) noexcept -> void {
+        if (ch.length_enable && ch.length != 0) {
+            if (--ch.length == 0) {
+                ch.enabled = false;
+            }
+        }
+    }
+
+    auto clock_envelope(APU::Envelope& env) noexcept -> void {
+        if (env.period == 0 || env.timer == 0) {
+            return;
+        }
+        if (--env.timer == 0) {
+            env.timer = env.period;
+            if (env.add && env.volume < 15) {
+                ++env.volume;
+            } else if (!env.add && env.volume > 0) {
+                --env.volume;
+            }
+        }
+    }
+
+    auto load_envelope(APU::Envelope& env, byte_t value) noexcept -> void {
+        env.volume = value >> 4;
+        env.add = value & 0x8;
+        env.period = value & 0x7;
+        env.timer = env.period ? env.period : 8;
+    }
+
+    /// Number of whole periods needed to reach until, used to skip edges of silent channels
+    auto skip_periods(std::uint64_t start, std::uint64_t until, std::uint32_t period) noexcept -> std::uint64_t {
+        return start < until ? (until - start + period - 1) / period : 0;
+    }
+}
+
+APU::APU(std::uint32_t sample_rate)
+    : left(clock_rate, sample_rate, sample_rate / 4), right(clock_rate, sample_rate, sample_rate / 4) {
+    power = true;
+}
+
+auto APU::reset() noexcept -> void {
+    regs = {};
+    square1 = {};
+    square2 = {};
+    wave = {};
+    noise = {};
+    output = {};
+    power = true;
+    frame_step = 0;
+    time = 0;
+    frame_start = 0;
+    frame_next = frame_sequencer_period;
+    left.clear();
+    right.clear();
+}
+
+auto APU::square_level(Square const& ch) const noexcept -> int {
+    if (!ch.enabled) {
+        return 0;
+    }
+    return ((duty_table[ch.duty] >> ch.phase) & 1) * ch.envelope.volume;
+}
+
+auto APU::wave_level() const noexcept -> int {
+    if (!wave.enabled) {
+        return 0;
+    }
+    constexpr byte_t shift[4] = {4, 0, 1, 2};
+    return wave.sample >> shift[(regs[0x0C] >> 5) & 3];
+}
+
+auto APU::noise_level() const noexcept -> int {
+    if (!noise.enabled) {
+        return 0;
+    }
+    return (~noise.lfsr & 1) * noise.envelope.volume;
+}
+
+auto APU::update_output(std::uint64_t at, int index, int level) noexcept -> void {
+    auto const nr50 = regs[0x14];
+    auto const nr51 = regs[0x15];
+    auto const l = ((nr51 >> (index + 4)) & 1) * level * (((nr50 >> 4) & 7) + 1);
+    auto const r = ((nr51 >> index) & 1) * level * ((nr50 & 7) + 1);
+    auto& out = output[index];
+    auto const when = static_cast<std::uint32_t>(at - frame_start);
+    if (l != out.left) {
+        left.add_delta(when, (l - out.left) * amplitude_scale);
+        out.left = l;
+    }
+    if (r != out.right) {
+        right.add_delta(when, (r - out.right) * amplitude_scale);
+        out.right = r;
+    }
+}
+
+auto APU::update_outputs(std::uint64_t at) noexcept -> void {
+    update_output(at, 0, square_level(square1));
+    update_output(at, 1, square_level(square2));
+    update_output(at, 2, wave_level());
+    update_output(at, 3, noise_level());
+}
+
+auto APU::run_channels(std::uint64_t until) noexcept -> void {
+    auto const run_square = [&](Square& ch, int index) {
+        if (!ch.enabled) {
+            return;
+        }
+        auto const period = (2048u - ch.freq) * 4;
+        auto t = time + ch.timer;
+        if (ch.envelope.volume == 0) {
+            auto const steps = skip_periods(t, until, period);
+            ch.phase = (ch.phase + steps) & 7;
+            t += steps * period;
+        }
+        for (; t < until; t += period) {
+            ch.phase = (ch.phase + 1) & 7;
+            update_output(t, index, square_level(ch));
+        }
+        ch.timer = static_cast<std::uint32_t>(t - until);
+    };
+    run_square(square1, 0);
+    run_square(square2, 1);
+
+    if (wave.enabled) {
+        auto const period = (2048u - wave.freq) * 2;
+        auto t = time + wave.timer;
+        for (; t < until; t += period) {
+            wave.position = (wave.position + 1) & 31;
+            auto const packed = regs[0x20 + (wave.position >> 1)];
+            wave.sample = (wave.position & 1) ? (packed & 0xF) : (packed >> 4);
+            update_output(t, 2, wave_level());
+        }
+        wave.timer = static_cast<std::uint32_t>(t - until);
+    }
+
+    if (noise.enabled) {
+        auto const nr43 = regs[0x12];
+        auto const shift = nr43 >> 4;
+        auto const period = noise_divisor[nr43 & 7] << shift;
+        auto t = time + noise.timer;
+        if (shift >= 14) {
+            // Shift clock is never delivered, LFSR stays frozen
+            t += skip_periods(t, until, period) * period;
+        }
+        for (; t < until; t += period) {
+            auto const bit = (noise.lfsr ^ (noise.lfsr >> 1)) & 1;
+            noise.lfsr = static_cast<word_t>((noise.lfsr >> 1) | (bit << 14));
+            if (nr43 & 0x8) {
+                noise.lfsr = static_cast<word_t>((noise.lfsr & ~0x40) | (bit << 6));
+            }
+            update_output(t, 3, noise_level());
+        }
+        noise.timer = static_cast<std::uint32_t>(t - until);
+    }
+}
+
+auto APU::sweep_next() noexcept -> word_t {
+    auto const nr10 = regs[0x00];
+    auto const delta = square1.sweep_shadow >> (nr10 & 7);
+    auto const result = (nr10 & 0x8) ? square1.sweep_shadow - delta : square1.sweep_shadow + delta;
+    if (result > 2047) {
+        square1.enabled = false;
+    }
+    return static_cast<word_t>(result);
+}
+
+auto APU::clock_frame_sequencer() noexcept -> void {
+    auto const step = frame_step;
+    frame_step = (frame_step + 1) & 7;
+    if ((step & 1) == 0) {
+        clock_length(square1);
+        clock_length(square2);
+        clock_length(wave);
+        clock_length(noise);
+    }
+    if ((step == 2 || step == 6) && square1.sweep_enabled && square1.sweep_timer != 0) {
+        if (--square1.sweep_timer == 0) {
+            auto const nr10 = regs[0x00];
+            auto const period = (nr10 >> 4) & 7;
+            square1.sweep_timer = period ? period : 8;
+            if (period) {
+                auto const freq = sweep_next();
+                if (freq <= 2047 && (nr10 & 7)) {
+                    square1.sweep_shadow = freq;
+                    square1.freq = freq;
+                    sweep_next();
+                }
+            }
+        }
+    }
+    if (step == 7) {
+        clock_envelope(square1.envelope);
+        clock_envelope(square2.envelope);
+        clock_envelope(noise.envelope);
+    }
+}
+
+auto APU::run_until(std::uint64_t cycles) noexcept -> void {
+    while (frame_next <= cycles) {
+        run_channels(frame_next);
+        time = frame_next;
+        frame_next += frame_sequencer_period;
+        if (power) {
+            clock_frame_sequencer();
+            update_outputs(time);
+        }
+    }
+    if (time < cycles) {
+        run_channels(cycles);
+        time = cycles;
+    }
+}
+
+auto APU::trigger_square(Square& ch, int index) noexcept -> void {
+    auto const base = index * 5;
+    ch.enabled = ch.dac;
+    if (ch.length == 0) {
+        ch.length = 64;
+    }
+    ch.timer = (2048u - ch.freq) * 4;
+    load_envelope(ch.envelope, regs[base + 2]);
+    if (index == 0) {
+        auto const nr10 = regs[0x00];
+        auto const period = (nr10 >> 4) & 7;
+        ch.sweep_shadow = ch.freq;
+        ch.sweep_timer = period ? period : 8;
+        ch.sweep_enabled = period != 0 || (nr10 & 7) != 0;
+        if (nr10 & 7) {
+            sweep_next();
+        }
+    }
+}
+
+auto APU::trigger_wave() noexcept -> void {
+    wave.enabled = wave.dac;
+    if (wave.length == 0) {
+        wave.length = 256;
+    }
+    wave.timer = (2048u - wave.freq) * 2;
+    wave.position = 0;
+}
+
+auto APU::trigger_noise() noexcept -> void {
+    noise.enabled = noise.dac;
+    if (noise.length == 0) {
+        noise.length = 64;
+    }
+    auto const nr43 = regs[0x12];
+    noise.timer = noise_divisor[nr43 & 7] << (nr43 >> 4);
+    noise.lfsr = 0x7FFF;
+    load_envelope(noise.envelope, regs[0x11]);
+}
+
+auto APU::read(std::uint64_t cycles, word_t address) noexcept -> byte_t {
+    if (address >= 0xFF30) {
+        return reg(address);
+    }
+    if (address == 0xFF26) {
+        run_until(cycles);
+        return static_cast<byte_t>((power << 7) | 0x70 | (noise.enabled << 3) | (wave.enabled << 2) |
+                                   (square2.enabled << 1) | (square1.enabled << 0));
+    }
+    return reg(address) | read_mask[address - 0xFF10];
+}
+
+auto APU::write(std::uint64_t cycles, word_t address, byte_t value) noexcept -> void {
+    run_until(cycles);
+    if (address >= 0xFF30) {
+        reg(address) = value;
+        return;
+    }
+    if (!power && address != 0xFF26) {
+        return;
+    }
+    reg(address) = value;
+    auto const write_square = [&](Square& ch, int index, int offset) {
+        switch (offset) {
+            case 1:
+                ch.duty = value >> 6;
+                ch.length = 64 - (value & 0x3F);
+                break;
+            case 2:
+                ch.dac = (value & 0xF8) != 0;
+                ch.enabled &= ch.dac;
+                break;
+            case 3:
+                ch.freq = static_cast<word_t>((ch.freq & 0x700) | value);
+                break;
+            case 4:
+                ch.freq = static_cast<word_t>((ch.freq & 0xFF) | ((value & 0x7) << 8));
+                ch.length_enable = value & 0x40;
+                if (value & 0x80) {
+                    trigger_square(ch, index);
+                }
+                break;
+        }
+    };
+    switch (address) {
+        case 0xFF10:
+        case 0xFF11:
+        case 0xFF12:
+        case 0xFF13:
+        case 0xFF14:
+            write_square(square1, 0, address - 0xFF10);
+            break;
+        case 0xFF16:
+        case 0xFF17:
+        case 0xFF18:
+        case 0xFF19:
+            write_square(square2, 1, address - 0xFF15);
+            break;
+        case 0xFF1A:
+            wave.dac = value & 0x80;
+            wave.enabled &= wave.dac;
+            break;
+        case 0xFF1B:
+            wave.length = 256 - value;
+            break;
+        case 0xFF1D:
+            wave.freq = static_cast<word_t>((wave.freq & 0x700) | value);
+            break;
+        case 0xFF1E:
+            wave.freq = static_cast<word_t>((wave.freq & 0xFF) | ((value & 0x7) << 8));
+            wave.length_enable = value & 0x40;
+            if (value & 0x80) {
+                trigger_wave();
+            }
+            break;
+        case 0xFF20:
+            noise.length = 64 - (value & 0x3F);
+            break;
+        case 0xFF21:
+            noise.dac = (value & 0xF8) != 0;
+            noise.enabled &= noise.dac;
+            break;
+        case 0xFF23:
+            noise.length_enable = value & 0x40;
+            if (value & 0x80) {
+                trigger_noise();
+            }
+            break;
+        case 0xFF26:
+            if (!(value & 0x80) && power) {
+                auto const wave_ram = regs;
+                regs = {};
+                std::copy(wave_ram.begin() + 0x20, wave_ram.end(), regs.begin() + 0x20);
+                square1 = {};
+                square2 = {};
+                wave = {};
+                noise = {};
+            } else if ((value & 0x80) && !power) {
+                frame_step = 0;
+            }
+            power = value & 0x80;
+            break;
+    }
+    update_outputs(time);
+}
+
+auto APU::end_frame(std::uint64_t cycles) noexcept -> void {
+    run_until(cycles);
+    auto const length = static_cast<std::uint32_t>(cycles - frame_start);
+    left.end_frame(length);
+    right.end_frame(length);
+    frame_start = cycles;
+}
+
+auto APU::read_samples(std::int16_t* out, std::size_t count) noexcept -> std::size_t {
+    count = left.read_samples(out, count, 2);
+    return right.read_samples(out + 1, count, 2);
+}
@@ -0,0 +1,118 @@
+#pragma once
+#include "blip.hpp"
+#include "common.hpp"
+
+/// Audio processing unit.
+/// Registers are only brought up to date when they are accessed or when a frame ends, channels are then advanced
+/// from one waveform edge to the next and only changes in output level are handed to the band-limited buffers.
+struct gb::APU final {
+    static constexpr std::uint32_t sample_rate_default = 48000;
+    static constexpr std::uint32_t frame_sequencer_period = clock_rate / 512;
+    static constexpr int amplitude_scale = 64;
+
+    struct Envelope {
+        byte_t volume = {};
+        byte_t period = {};
+        byte_t timer = {};
+        bool add = {};
+    };
+
+    struct Square {
+        bool enabled = {};
+        bool dac = {};
+        bool length_enable = {};
+        word_t length = {};
+        word_t freq = {};
+        byte_t duty = {};
+        byte_t phase = {};
+        std::uint32_t timer = {};
+        Envelope envelope = {};
+        // Sweep is only wired up for channel 1
+        bool sweep_enabled = {};
+        byte_t sweep_timer = {};
+        word_t sweep_shadow = {};
+    };
+
+    struct Wave {
+        bool enabled = {};
+        bool dac = {};
+        bool length_enable = {};
+        word_t length = {};
+        word_t freq = {};
+        byte_t position = {};
+        byte_t sample = {};
+        std::uint32_t timer = {};
+    };
+
+    struct Noise {
+        bool enabled = {};
+        bool dac = {};
+        bool length_enable = {};
+        word_t length = {};
+        word_t lfsr = {};
+        std::uint32_t timer = {};
+        Envelope envelope = {};
+    };
+
+    struct Output {
+        int left = {};
+        int right = {};
+    };
+
+    std::array<byte_t, 0x30> regs = {};
+    Square square1 = {};
+    Square square2 = {};
+    Wave wave = {};
+    Noise noise = {};
+    std::array<Output, 4> output = {};
+    bool power = {};
+    byte_t frame_step = {};
+    std::uint64_t time = {};
+    std::uint64_t frame_start = {};
+    std::uint64_t frame_next = frame_sequencer_period;
+    Blip left;
+    Blip right;
+
+    explicit APU(std::uint32_t sample_rate = sample_rate_default);
+
+    /// Register access in 0xFF10 - 0xFF3F, cycles is the current bus time in base clocks
+    auto read(std::uint64_t cycles, word_t address) noexcept -> byte_t;
+
+    auto write(std::uint64_t cycles, word_t address, byte_t value) noexcept -> void;
+
+    /// Synthesizes everything up to cycles and publishes the samples
+    auto end_frame(std::uint64_t cycles) noexcept -> void;
+
+    auto samples_avail() const noexcept -> std::size_t { return left.samples_avail(); }
+
+    /// Reads up to count interleaved stereo sample pairs
+    auto read_samples(std::int16_t* out, std::size_t count) noexcept -> std::size_t;
+
+    auto reset() noexcept -> void;
+
+    auto run_until(std::uint64_t cycles) noexcept -> void;
+
+    auto run_channels(std::uint64_t until) noexcept -> void;
+
+    auto clock_frame_sequencer() noexcept -> void;
+
+    auto update_output(std::uint64_t at, int index, int level) noexcept -> void;
+
+    auto update_outputs(std::uint64_t at) noexcept -> void;
+
+    auto square_level(Square const& ch) const noexcept -> int;
+
+    auto wave_level() const noexcept -> int;
+
+    auto noise_level() const noexcept -> int;
+
+    auto trigger_square(Square& ch, int index) noexcept -> void;
+
+    auto trigger_wave() noexcept -> void;
+
+    auto trigger_noise() noexcept -> void;
+
+    auto sweep_next() noexcept -> word_t;
+
+    auto reg(word_t address) noexcept -> byte_t& { return regs[address - 0xFF10]; }
+};
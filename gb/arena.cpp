@@ -0,0 +1,41 @@
+#include "arena.hpp"
+
+#include <sys/mman.h>
+
+#include <cstdint>
+
+using namespace gb;
+
+namespace {
+    auto rounded(std::size_t size) noexcept -> std::size_t {
+        return (size + Arena::huge_page - 1) & ~(Arena::huge_page - 1);
+    }
+}
+
+auto Arena::allocate(std::size_t size) noexcept -> void* {
+    // Map one huge page more than needed and trim both ends, mmap itself only promises small page alignment
+    auto const length = rounded(size);
+    auto const map = ::mmap(nullptr, length + huge_page, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (map == MAP_FAILED) {
+        return nullptr;
+    }
+    auto const start = reinterpret_cast<std::uintptr_t>(map);
+    auto const aligned = (start + huge_page - 1) & ~std::uintptr_t{huge_page - 1};
+    if (aligned != start) {
+        ::munmap(map, aligned - start);
+    }
+    if (auto const tail = start + huge_page - aligned) {
+        ::munmap(reinterpret_cast<void*>(aligned + length), tail);
+    }
+    auto const block = reinterpret_cast<void*>(aligned);
+#ifdef MADV_HUGEPAGE
+    ::madvise(block, length, MADV_HUGEPAGE);
+#endif
+    return block;
+}
+
+auto Arena::release(void* block, std::size_t size) noexcept -> void {
+    if (block) {
+        ::munmap(block, rounded(size));
+    }
+}
@@ -0,0 +1,18 @@
+#pragma once
+#include <cstddef>
+
+#include "common.hpp"
+
+/// Memory for one emulator instance.
+/// Every block is its own anonymous mapping, aligned to and padded out to whole huge pages and marked for transparent
+/// huge pages where the kernel supports them. A machine then sits in a single 2 MB page, one TLB entry covers all
+/// of its state and instances never share a cache line.
+struct gb::Arena final {
+    static constexpr std::size_t huge_page = std::size_t{2} << 20;
+
+    /// Rounds size up to whole huge pages, returns nullptr when out of memory
+    static auto allocate(std::size_t size) noexcept -> void*;
+
+    /// size must be the one given to allocate
+    static auto release(void* block, std::size_t size) noexcept -> void;
+};
@@ -0,0 +1,67 @@
+#include "blip.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+
+using namespace gb;
+
+Blip::Blip(std::uint32_t clock_rate, std::uint32_t sample_rate, std::size_t capacity) {
+    buffer.resize(capacity + width);
+    factor = (static_cast<std::uint64_t>(sample_rate) << time_bits) / clock_rate;
+
+    // Blackman windowed sinc, cut slightly below nyquist, one row per sub-sample phase
+    constexpr auto cutoff = 0.90;
+    for (int phase = 0; phase != phase_count; ++phase) {
+        auto taps = std::array<double, width>{};
+        auto sum = 0.0;
+        for (int i = 0; i != width; ++i) {
+            auto const x = (i + 1 - half_width) - static_cast<double>(phase) / phase_count;
+            auto const angle = std::numbers::pi * x * cutoff;
+            auto const sinc = x == 0.0 ? 1.0 : std::sin(angle) / angle;
+            auto const w = std::numbers::pi * x / half_width;
+            auto const window = 0.42 + 0.5 * std::cos(w) + 0.08 * std::cos(2 * w);
+            taps[i] = std::abs(x) < half_width ? sinc * window : 0.0;
+            sum += taps[i];
+        }
+        // Rows have to sum exactly to unity or integration drifts
+        auto& row = kernel[phase];
+        auto total = 0;
+        for (int i = 0; i != width; ++i) {
+            row[i] = static_cast<std::int16_t>(std::lround(taps[i] / sum * (1 << delta_bits)));
+            total += row[i];
+        }
+        row[half_width - 1 + (phase < phase_count / 2)] += static_cast<std::int16_t>((1 << delta_bits) - total);
+    }
+}
+
+auto Blip::end_frame(std::uint32_t time) noexcept -> void {
+    offset += time * factor;
+    auto const limit = static_cast<std::uint64_t>(buffer.size() - width) << time_bits;
+    offset = std::min(offset, limit);
+}
+
+auto Blip::read_samples(std::int16_t* out, std::size_t count, std::size_t stride) noexcept -> std::size_t {
+    auto const avail = samples_avail();
+    count = std::min(count, avail);
+    auto sum = integrator;
+    for (std::size_t i = 0; i != count; ++i) {
+        sum += buffer[i];
+        auto const sample = std::clamp(sum >> delta_bits, -0x8000, 0x7FFF);
+        out[i * stride] = static_cast<std::int16_t>(sample);
+        sum -= sample << (delta_bits - bass_shift);
+    }
+    integrator = sum;
+    // Only the unread samples and kernel tails past them can be non-zero
+    auto const tail = avail - count + width;
+    std::copy_n(buffer.begin() + count, tail, buffer.begin());
+    std::fill_n(buffer.begin() + tail, count, 0);
+    offset -= static_cast<std::uint64_t>(count) << time_bits;
+    return count;
+}
+
+auto Blip::clear() noexcept -> void {
+    std::fill(buffer.begin(), buffer.end(), 0);
+    offset = 0;
+    integrator = 0;
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <vector>
+
+#include "common.hpp"
+
+/// Band-limited step buffer.
+/// Amplitude changes are added as deltas at clock times, every delta is spread over a short windowed-sinc kernel
+/// and the buffer is integrated only when samples are read, so synthesis cost scales with edges, not with clocks.
+struct gb::Blip final {
+    static constexpr int phase_bits = 5;
+    static constexpr int phase_count = 1 << phase_bits;
+    static constexpr int half_width = 8;
+    static constexpr int width = half_width * 2;
+    static constexpr int delta_bits = 15;
+    static constexpr int bass_shift = 9;
+    static constexpr int time_bits = 32;
+
+    std::vector<std::int32_t> buffer = {};
+    std::array<std::array<std::int16_t, width>, phase_count> kernel = {};
+    std::uint64_t factor = {};
+    std::uint64_t offset = {};
+    std::int32_t integrator = {};
+
+    Blip(std::uint32_t clock_rate, std::uint32_t sample_rate, std::size_t capacity);
+
+    /// Adds amplitude change at clock time relative to the start of current frame
+    auto add_delta(std::uint32_t time, int delta) noexcept -> void {
+        auto const position = offset + time * factor;
+        auto const index = static_cast<std::size_t>(position >> time_bits);
+        if (index + width > buffer.size()) [[unlikely]] {
+            return;
+        }
+        auto const phase = (position >> (time_bits - phase_bits)) & (phase_count - 1);
+        auto const& taps = kernel[phase];
+        auto out = buffer.data() + index;
+        for (int i = 0; i != width; ++i) {
+            out[i] += delta * taps[i];
+        }
+    }
+
+    /// Ends current frame after given number of clocks, making its samples available for reading
+    auto end_frame(std::uint32_t time) noexcept -> void;
+
+    auto samples_avail() const noexcept -> std::size_t { return static_cast<std::size_t>(offset >> time_bits); }
+
+    /// Reads up to count samples into out, writing every stride-th element
+    auto read_samples(std::int16_t* out, std::size_t count, std::size_t stride) noexcept -> std::size_t;
+
+    auto clear() noexcept -> void;
+};
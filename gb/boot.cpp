@@ -0,0 +1,61 @@
+#include "boot.hpp"
+
+#include <filesystem>
+#include <fstream>
+
+#include "header.hpp"
+#include "mcb1.hpp"
+
+using namespace gb;
+
+auto Boot::install(CPU::MCB1& mem, byte_t const* data, std::size_t size) noexcept -> bool {
+    if (size != dmg_size && size != cgb_size) {
+        return false;
+    }
+    std::copy_n(data, size, mem.BOOT.begin());
+    mem.boot_size = size;
+    return true;
+}
+
+auto Boot::install(CPU::MCB1& mem, char const* filename) -> bool {
+    auto error = std::error_code{};
+    auto const size = std::filesystem::file_size(filename, error);
+    auto data = std::array<byte_t, cgb_size>{};
+    if (auto file = std::ifstream(filename, std::ios::binary);
+        error || size > data.size() ||
+        !file.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(size))) {
+        return false;
+    }
+    return install(mem, data.data(), size);
+}
+
+auto Boot::start(CPU& cpu, CPU::MCB1& mem) noexcept -> void {
+    if (!mem.boot_size) {
+        return fast(cpu, mem);
+    }
+    // Power on state, the boot ROM sets up everything else itself
+    cpu = CPU{};
+    mem.set_cgb(mem.boot_size == cgb_size);
+    mem.boot_mapped = true;
+    mem.io_write(0xFF26, 0x00);
+    mem.io_write(0xFF40, 0x00);
+    mem.io_write(0xFF47, 0x00);
+}
+
+auto Boot::fast(CPU& cpu, CPU::MCB1& mem) noexcept -> void {
+    mem.set_cgb(Header::parse(mem.ROM.data(), Header::end).cgb);
+    cpu = mem.cgb ? cgb_cpu : dmg_cpu;
+    for (auto const& reg : io) {
+        mem.io_write(reg.address, mem.cgb ? reg.cgb : reg.dmg);
+    }
+    mem.dma_source = 0xFF;
+    mem.HRAM[0x7F] = 0x00;
+    if (!mem.cgb) {
+        std::copy(logo_tiles.begin(), logo_tiles.end(), mem.VRAM.begin() + 0x10);
+        for (auto i = 0; i != 12; ++i) {
+            mem.VRAM[0x1904 + i] = static_cast<byte_t>(1 + i);
+            mem.VRAM[0x1924 + i] = static_cast<byte_t>(13 + i);
+        }
+        mem.VRAM[0x1910] = 25;
+    }
+}
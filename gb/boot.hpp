@@ -0,0 +1,100 @@
+#pragma once
+#include <array>
+
+#include "cpu.hpp"
+
+/// Machine startup.
+/// With a boot ROM installed the CPU starts at 0x0000 with the image mapped over the cartridge until the game writes
+/// 0xFF50. Otherwise fast() puts the machine straight into the state the boot ROM leaves behind at 0x100, taken from
+/// the constant tables below, which skips the roughly 2.5 million cycles of the logo animation.
+struct gb::Boot final {
+    static constexpr std::size_t dmg_size = 0x100;
+    static constexpr std::size_t cgb_size = 0x900;
+
+    /// Registers at 0x100
+    static constexpr CPU dmg_cpu = {.reg_b = 0x00,
+                                    .reg_c = 0x13,
+                                    .reg_d = 0x00,
+                                    .reg_e = 0xD8,
+                                    .reg_h = 0x01,
+                                    .reg_l = 0x4D,
+                                    .reg_a = 0x01,
+                                    .reg_f = CPU::Flags::from_byte(0xB0),
+                                    .reg_sp = 0xFFFE,
+                                    .reg_ip = 0x100};
+    static constexpr CPU cgb_cpu = {.reg_b = 0x00,
+                                    .reg_c = 0x00,
+                                    .reg_d = 0xFF,
+                                    .reg_e = 0x56,
+                                    .reg_h = 0x00,
+                                    .reg_l = 0x0D,
+                                    .reg_a = 0x11,
+                                    .reg_f = CPU::Flags::from_byte(0x80),
+                                    .reg_sp = 0xFFFE,
+                                    .reg_ip = 0x100};
+
+    struct Register {
+        word_t address = {};
+        byte_t dmg = {};
+        byte_t cgb = {};
+    };
+
+    /// I/O registers at 0x100, written in this order through io_write so every unit sees them. Sound is powered
+    /// before its channels, 0xFF46 is left out because writing it starts an OAM DMA. The timer (0xFF04 - 0xFF07) and
+    /// IF (0xFF0F) are not emulated, so they have no rows here.
+    static constexpr Register io[] = {
+        {0xFF00, 0xCF, 0xCF}, {0xFF01, 0x00, 0x00}, {0xFF02, 0x7E, 0x7F}, {0xFF26, 0xF1, 0xF1}, {0xFF10, 0x80, 0x80},
+        {0xFF11, 0xBF, 0xBF}, {0xFF12, 0xF3, 0xF3}, {0xFF13, 0xFF, 0xFF}, {0xFF14, 0xBF, 0xBF}, {0xFF16, 0x3F, 0x3F},
+        {0xFF17, 0x00, 0x00}, {0xFF18, 0xFF, 0xFF}, {0xFF19, 0xBF, 0xBF}, {0xFF1A, 0x7F, 0x7F}, {0xFF1B, 0xFF, 0xFF},
+        {0xFF1C, 0x9F, 0x9F}, {0xFF1D, 0xFF, 0xFF}, {0xFF1E, 0xBF, 0xBF}, {0xFF20, 0xFF, 0xFF}, {0xFF21, 0x00, 0x00},
+        {0xFF22, 0x00, 0x00}, {0xFF23, 0xBF, 0xBF}, {0xFF24, 0x77, 0x77}, {0xFF25, 0xF3, 0xF3}, {0xFF40, 0x91, 0x91},
+        {0xFF41, 0x85, 0x85}, {0xFF42, 0x00, 0x00}, {0xFF43, 0x00, 0x00}, {0xFF45, 0x00, 0x00}, {0xFF47, 0xFC, 0xFC},
+        {0xFF48, 0xFF, 0xFF}, {0xFF49, 0xFF, 0xFF}, {0xFF4A, 0x00, 0x00}, {0xFF4B, 0x00, 0x00}, {0xFF4F, 0xFF, 0x00},
+        {0xFF70, 0xFF, 0x00},
+    };
+
+    /// Logo every licensed cartridge carries at 0x104, the boot ROM refuses to start anything else
+    static constexpr std::array<byte_t, 48> logo = {
+        0xCE, 0xED, 0x66, 0x66, 0xCC, 0x0D, 0x00, 0x0B, 0x03, 0x73, 0x00, 0x83, 0x00, 0x0C, 0x00, 0x0D,
+        0x00, 0x08, 0x11, 0x1F, 0x88, 0x89, 0x00, 0x0E, 0xDC, 0xCC, 0x6E, 0xE6, 0xDD, 0xDD, 0xD9, 0x99,
+        0xBB, 0xBB, 0x67, 0x63, 0x6E, 0x0E, 0xEC, 0xCC, 0xDD, 0xDC, 0x99, 0x9F, 0xBB, 0xB9, 0x33, 0x3E,
+    };
+
+    /// Trademark symbol drawn right of the logo, one bitplane
+    static constexpr std::array<byte_t, 8> trademark = {0x3C, 0x42, 0xB9, 0xA5, 0xB9, 0xA5, 0x42, 0x3C};
+
+    /// Tiles 1 - 25 from 0x8010 as the DMG boot ROM draws them: every logo nibble becomes two rows of doubled
+    /// pixels, logo bytes 0 - 23 fill tiles 1 - 12 for the top half and bytes 24 - 47 tiles 13 - 24 below them
+    static constexpr auto logo_tiles = [] {
+        auto tiles = std::array<byte_t, 25 * 16>{};
+        auto const doubled = [](unsigned nibble) {
+            auto result = 0u;
+            for (auto bit = 0; bit != 4; ++bit) {
+                result |= ((nibble >> bit) & 1u) * (3u << (bit * 2));
+            }
+            return static_cast<byte_t>(result);
+        };
+        auto out = std::size_t{};
+        for (auto const value : logo) {
+            for (auto const nibble : {unsigned{value} >> 4, unsigned{value} & 0xF}) {
+                tiles[out] = tiles[out + 2] = doubled(nibble);
+                out += 4;
+            }
+        }
+        for (auto i = std::size_t{}; i != trademark.size(); ++i) {
+            tiles[out + i * 2] = trademark[i];
+        }
+        return tiles;
+    }();
+
+    /// Copies a DMG (256 byte) or CGB (2304 byte) boot ROM into mem, returns false for any other size
+    static auto install(CPU::MCB1& mem, byte_t const* data, std::size_t size) noexcept -> bool;
+
+    static auto install(CPU::MCB1& mem, char const* filename) -> bool;
+
+    /// Starts the loaded cartridge, through the installed boot ROM if there is one
+    static auto start(CPU& cpu, CPU::MCB1& mem) noexcept -> void;
+
+    /// State the boot ROM leaves behind, CGB carts keep the white palettes and get no logo
+    static auto fast(CPU& cpu, CPU::MCB1& mem) noexcept -> void;
+};
@@ -0,0 +1,113 @@
+#include "catalog.hpp"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <sstream>
+
+#include "compat.hpp"
+#include "header.hpp"
+#include "kernels.hpp"
+#include "mcb1.hpp"
+
+using namespace gb;
+
+auto Catalog::hash(byte_t const* rom, std::size_t size) noexcept -> std::uint64_t {
+    return Kernels::best().hash(rom, size, 0);
+}
+
+auto Catalog::load(std::filesystem::path const& filename) -> bool {
+    entries.clear();
+    changed = false;
+    auto file = std::ifstream(filename);
+    if (!file) {
+        return !std::filesystem::exists(filename);
+    }
+    for (auto line = std::string{}; std::getline(file, line);) {
+        auto title = std::string{};
+        if (auto const comment = line.find('#'); comment != std::string::npos) {
+            title = line.substr(std::min(comment + 2, line.size()));
+            line.resize(comment);
+        }
+        auto fields = std::istringstream(line);
+        auto hash = std::string{}, renderer = std::string{}, loops = std::string{};
+        auto entry = Entry{.title = std::move(title)};
+        if (!(fields >> hash)) {
+            continue;
+        }
+        if (!(fields >> entry.size >> renderer >> loops)) {
+            return false;
+        }
+        try {
+            entry.hash = std::stoull(hash, nullptr, 16);
+            for (auto start = std::size_t{}; loops != "-" && start < loops.size();) {
+                auto const end = std::min(loops.find(',', start), loops.size());
+                auto const address = std::stoul(loops.substr(start, end - start), nullptr, 16);
+                if (address > 0xFFFF) {
+                    return false;
+                }
+                entry.idle_loops.push_back(static_cast<word_t>(address));
+                start = end + 1;
+            }
+        } catch (std::exception const&) {
+            return false;
+        }
+        if (renderer != "-" && !(entry.renderer = Compat::parse(renderer))) {
+            return false;
+        }
+        entries.push_back(std::move(entry));
+    }
+    return true;
+}
+
+auto Catalog::save(std::filesystem::path const& filename) const -> bool {
+    auto temporary = filename;
+    temporary += ".tmp" + std::to_string(getpid());
+    {
+        auto file = std::ofstream(temporary);
+        file << "# hash size renderer idle_loops\n";
+        for (auto const& entry : entries) {
+            char hash[20];
+            snprintf(hash, sizeof(hash), "%016llx", static_cast<unsigned long long>(entry.hash));
+            auto const renderer = !entry.renderer                              ? "-"
+                                  : *entry.renderer == PPU::Renderer::FIFO ? "fifo"
+                                                                               : "scanline";
+            auto loops = std::string{};
+            for (auto const address : entry.idle_loops) {
+                char text[8];
+                snprintf(text, sizeof(text), loops.empty() ? "%04x" : ",%04x", address);
+                loops += text;
+            }
+            file << hash << ' ' << entry.size << ' ' << renderer << ' ' << (loops.empty() ? "-" : loops);
+            file << (entry.title.empty() ? "" : " # ") << entry.title << '\n';
+        }
+        if (!file.flush()) {
+            return false;
+        }
+    }
+    auto error = std::error_code{};
+    std::filesystem::rename(temporary, filename, error);
+    return !error;
+}
+
+auto Catalog::attach(CPU::MCB1& mem, std::size_t size) -> Entry& {
+    auto const key = hash(mem.ROM.data(), size);
+    auto const found =
+        std::find_if(entries.begin(), entries.end(), [&](auto& e) { return e.hash == key && e.size == size; });
+    if (found != entries.end()) {
+        mem.idle_count = std::min(found->idle_loops.size(), mem.idle_loops.size());
+        std::copy_n(found->idle_loops.begin(), mem.idle_count, mem.idle_loops.begin());
+        return *found;
+    }
+    mem.find_idle_loops(size);
+    auto& entry = entries.emplace_back();
+    entry.hash = key;
+    entry.size = size;
+    entry.idle_loops.assign(mem.idle_loops.begin(), mem.idle_loops.begin() + mem.idle_count);
+    entry.title = Header::parse(mem.ROM.data(), size).title;
+    changed = true;
+    return entry;
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "cpu.hpp"
+#include "ppu.hpp"
+
+/// On-disk index of ROMs keyed by a hash of the whole image.
+/// Each entry caches what was derived from a ROM, the idle loops idle_skip() fast-forwards and the renderer the
+/// compatibility database picked for it, so later runs of the same image skip the ROM scan and need no database.
+/// Lines read "hash size renderer loops", loops as comma separated hex addresses and - for none, followed by the
+/// title as a comment. The file is only written when something changed, through a rename so concurrent runs of a
+/// corpus never read half of it.
+struct gb::Catalog final {
+    struct Entry {
+        std::uint64_t hash = {};
+        std::uint64_t size = {};
+        /// Written as -
+        std::optional<PPU::Renderer> renderer = {};
+        std::vector<word_t> idle_loops = {};
+        std::string title = {};
+    };
+
+    std::vector<Entry> entries = {};
+    bool changed = {};
+
+    static auto hash(byte_t const* rom, std::size_t size) noexcept -> std::uint64_t;
+
+    /// A missing file is an empty catalog
+    auto load(std::filesystem::path const& filename) -> bool;
+
+    auto save(std::filesystem::path const& filename) const -> bool;
+
+    /// Entry of the size byte image in mem, scanned and added on first sight. Either way mem gets its idle loops.
+    auto attach(CPU::MCB1& mem, std::size_t size) -> Entry&;
+};
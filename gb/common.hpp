@@ -22,6 +22,43 @@ namespace gb {
     using sword_t = std::int16_t;
 
     struct CPU;
+    struct APU;
+    struct Arena;
+    struct Blip;
+    struct Boot;
+    struct Catalog;
+    struct Compat;
+    struct Debugger;
+    struct Disasm;
+    struct GDB;
+    struct Golden;
+    struct Header;
+    struct Joypad;
+    struct Kernels;
+    struct LZ;
+    struct Link;
+    struct Machine;
+    struct Metrics;
+    struct PNG;
+    struct PPU;
+    struct Realtime;
+    struct Rewind;
+    struct Save;
+    struct Serial;
+    struct State;
+    struct WAV;
+
+    template <typename T, std::size_t N>
+    struct SPSC;
+
+    template <typename T>
+    struct Triple;
+
+    /// Base clock of the system in Hz, everything outside of the CPU is timed in these units
+    constexpr inline std::uint32_t clock_rate = 4194304;
+
+    /// Length of one video frame in base clocks
+    constexpr inline std::uint32_t frame_cycles = 70224;
 
     gb_func inline word_unpack(word_t value) noexcept->pair_t { return pair_t{(byte_t)(value), (byte_t)(value >> 8)}; }
 
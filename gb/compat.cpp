@@ -0,0 +1,88 @@
+#include "compat.hpp"
+
+#include <exception>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+using namespace gb;
+
+auto Compat::parse(std::string_view name) noexcept -> std::optional<PPU::Renderer> {
+    if (name == "scanline") {
+        return PPU::Renderer::SCANLINE;
+    }
+    if (name == "fifo") {
+        return PPU::Renderer::FIFO;
+    }
+    return std::nullopt;
+}
+
+auto Compat::load(std::filesystem::path const& filename) -> bool {
+    auto file = std::ifstream(filename);
+    if (!file) {
+        return false;
+    }
+    entries.clear();
+    for (auto line = std::string{}; std::getline(file, line);) {
+        if (auto const comment = line.find('#'); comment != std::string::npos) {
+            line.resize(comment);
+        }
+        auto fields = std::istringstream(line);
+        auto header = std::string{}, global = std::string{}, renderer = std::string{};
+        if (!(fields >> header)) {
+            continue;
+        }
+        if (!(fields >> global >> renderer)) {
+            return false;
+        }
+        auto entry = Entry{};
+        try {
+            auto const checksum = std::stoul(header, nullptr, 16);
+            if (checksum > 0xFF) {
+                return false;
+            }
+            entry.header_checksum = static_cast<byte_t>(checksum);
+            if (global != "-") {
+                auto const value = std::stoul(global, nullptr, 16);
+                if (value > 0xFFFF) {
+                    return false;
+                }
+                entry.global_checksum = static_cast<word_t>(value);
+            }
+        } catch (std::exception const&) {
+            return false;
+        }
+        if (auto const choice = parse(renderer)) {
+            entry.renderer = *choice;
+        } else {
+            return false;
+        }
+        entries.push_back(entry);
+    }
+    return true;
+}
+
+auto Compat::renderer(byte_t const* rom, std::size_t size) const noexcept -> PPU::Renderer {
+    return forced ? *forced : listed(rom, size);
+}
+
+auto Compat::listed(byte_t const* rom, std::size_t size) const noexcept -> PPU::Renderer {
+    if (size < 0x150) {
+        return PPU::Renderer::SCANLINE;
+    }
+    // Stored big endian, unlike everything else in the header
+    auto const global = word_pack(rom[0x14F], rom[0x14E]);
+    auto result = PPU::Renderer::SCANLINE;
+    for (auto const& entry : entries) {
+        if (entry.header_checksum != rom[0x14D]) {
+            continue;
+        }
+        if (entry.global_checksum == global) {
+            return entry.renderer;
+        }
+        if (!entry.global_checksum) {
+            result = entry.renderer;
+        }
+    }
+    return result;
+}
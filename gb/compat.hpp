@@ -0,0 +1,38 @@
+#pragma once
+#include <filesystem>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#include "ppu.hpp"
+
+/// Renderer choice per cartridge.
+/// Most games look right with the scanline renderer, the few that change registers in the middle of a line are listed
+/// in a database file and recognised by the header checksum at 0x14D. An entry may also give the global checksum at
+/// 0x14E to tell apart carts that share one of the 256 header checksums.
+struct gb::Compat final {
+    struct Entry {
+        byte_t header_checksum = {};
+        /// Any cart with the header checksum when empty, written as -
+        std::optional<word_t> global_checksum = {};
+        PPU::Renderer renderer = {};
+    };
+
+    std::vector<Entry> entries = {};
+
+    /// Choice made for the whole run, wins over every entry
+    std::optional<PPU::Renderer> forced = {};
+
+    /// scanline or fifo
+    static auto parse(std::string_view name) noexcept -> std::optional<PPU::Renderer>;
+
+    /// Lines of "header global renderer", checksums in hex, # starts a comment
+    auto load(std::filesystem::path const& filename) -> bool;
+
+    /// Renderer for the cartridge in rom, the forced one or else listed()
+    auto renderer(byte_t const* rom, std::size_t size) const noexcept -> PPU::Renderer;
+
+    /// What the database says for rom, the scanline renderer unless listed. An exact global checksum match beats an
+    /// entry for any global checksum.
+    auto listed(byte_t const* rom, std::size_t size) const noexcept -> PPU::Renderer;
+};
@@ -1,6 +1,7 @@
 #include "cpu.hpp"
 
 #include "cpu_exe.hpp"
+#include "cpu_info.hpp"
 
 using namespace gb;
 
@@ -8,10 +9,19 @@ auto CPU::step(BUS &bus) noexcept -> Status { return CPU::EXE::step(*this, bus);
 
 auto CPU::trace(BUS &bus) const noexcept -> void {
     auto address = this->reg_ip;
-    auto const op0 = bus.read_byte(address++);
-    auto const op1 = bus.read_byte(address++);
-    auto const op2 = bus.read_byte(address++);
-    auto const op3 = bus.read_byte(address++);
+    byte_t code[4] = {};
+    code[0] = bus.read_byte(address++);
+    code[1] = bus.read_byte(address++);
+    auto const& info = INFO::decode(code[0], code[1]);
+    for (auto i = 2; i < info.length; ++i) {
+        code[i] = bus.read_byte(address++);
+    }
+    // Only the bytes that belong to the instruction, padded so columns stay aligned
+    char bytes[16] = {};
+    for (auto i = 0, offset = 0; i != 4; ++i) {
+        auto const format = i < info.length ? "%s%02X" : "%s  ";
+        offset += snprintf(bytes + offset, sizeof(bytes) - offset, format, i ? " " : "", code[i]);
+    }
     fprintf(stderr,
             "A: %02X F: %02X "
             "B: %02X C: %02X "
@@ -19,7 +29,7 @@ auto CPU::trace(BUS &bus) const noexcept -> void {
             "H: %02X L: %02X "
             "SP: %04X "
             "PC: 00:%04X "
-            "(%02X %02X %02X %02X)\n",
+            "(%s) %u/%u\n",
             this->reg_a,
             this->reg_f.into_byte(),
             this->reg_b,
@@ -30,8 +40,7 @@ auto CPU::trace(BUS &bus) const noexcept -> void {
             this->reg_l,
             this->reg_sp,
             this->reg_ip,
-            op0,
-            op1,
-            op2,
-            op3);
+            bytes,
+            info.cycles,
+            info.cycles_taken);
 }
@@ -2,7 +2,7 @@
 #include "common.hpp"
 
 struct gb::CPU final {
-    enum class Status : byte_t { OK, BAD, STOP, HALT };
+    enum class Status : byte_t { OK, BAD, STOP, HALT, BREAK };
 
     enum class REG8 : byte_t { B, C, D, E, H, L, HL, A };
 
@@ -48,6 +48,8 @@ struct gb::CPU final {
     struct BUS;
     struct CTX;
     struct EXE;
+    struct FLAT;
+    struct INFO;
     struct MCB1;
     struct MCB2;
     struct MCB3;
@@ -295,4 +295,52 @@ struct gb::CPU::ALU {
         flags.subtract = false;
         return {flags, static_cast<word_t>(result)};
     }
+
+    /// Lookup tables
+
+#ifdef GB_ALU_TABLES
+    static constexpr bool use_tables = true;
+#else
+    static constexpr bool use_tables = false;
+#endif
+
+    /// Every result of a unary op for all flag and operand combinations, Flags as stored in the low 32 bits and the
+    /// value above them, so neither side converts flags to a byte and back
+    struct Lookup {
+        std::uint64_t entries[16 * 256];
+    };
+
+    /// Gathers the four flag bools into bits 8 - 11 with a single multiply, tests/programs.cpp checks the layout
+    gb_func static lookup_index(Flags flags, byte_t lhs) noexcept->std::size_t {
+        auto const raw = std::bit_cast<std::uint32_t>(flags);
+        return ((raw * 0x01020408u) >> 16 & 0xF00) | lhs;
+    }
+
+    /// Built at compile time from OP itself, only instantiated where a table is actually used
+    template <auto OP>
+    static constexpr Lookup lookup = [] {
+        auto table = Lookup{};
+        for (auto index = std::size_t{}; index != std::size(table.entries); ++index) {
+            auto const result =
+                OP(Flags::from_byte(static_cast<byte_t>(index >> 8 << 4)), static_cast<byte_t>(index & 0xFF));
+            table.entries[index] = std::bit_cast<std::uint32_t>(result.flags) | std::uint64_t{result.value} << 32;
+        }
+        return table;
+    }();
+
+    template <auto OP>
+    gb_func static lookup_result(Flags flags, byte_t lhs) noexcept->Result8 {
+        auto const entry = lookup<OP>.entries[lookup_index(flags, lhs)];
+        return {std::bit_cast<Flags>(static_cast<std::uint32_t>(entry)), static_cast<byte_t>(entry >> 32)};
+    }
+
+    /// Runs OP, or reads its result from a table when built with GB_ALU_TABLES
+    template <auto OP>
+    gb_func static unary(Flags flags, byte_t lhs) noexcept->Result8 {
+        if constexpr (use_tables) {
+            return lookup_result<OP>(flags, lhs);
+        } else {
+            return OP(flags, lhs);
+        }
+    }
 };
@@ -505,7 +505,7 @@ struct gb::CPU::EXE {
         constexpr auto const reg = static_cast<REG8>((OP >> 3) & 0b111);
         auto const flags = ctx.flags_get();
         auto const value = ctx.reg8_get<reg>();
-        auto const result = ALU::op_misc_inc(flags, value);
+        auto const result = ALU::template unary<&ALU::op_misc_inc>(flags, value);
         ctx.flags_set(result.flags);
         ctx.reg8_set<reg>(result.value);
         return Status::OK;
@@ -518,7 +518,7 @@ struct gb::CPU::EXE {
         constexpr auto const reg = static_cast<REG8>((OP >> 3) & 0b111);
         auto const flags = ctx.flags_get();
         auto const value = ctx.reg8_get<reg>();
-        auto const result = ALU::op_misc_dec(flags, value);
+        auto const result = ALU::template unary<&ALU::op_misc_dec>(flags, value);
         ctx.flags_set(result.flags);
         ctx.reg8_set<reg>(result.value);
         return Status::OK;
@@ -591,7 +591,7 @@ struct gb::CPU::EXE {
     gb_func static op1(CTX ctx) noexcept->Status {
         auto const flags = ctx.flags_get();
         auto const lhs = ctx.reg8_get<REG8::A>();
-        auto const result = ALU::op_misc_daa(flags, lhs);
+        auto const result = ALU::template unary<&ALU::op_misc_daa>(flags, lhs);
         ctx.flags_set(result.flags);
         ctx.reg8_set<REG8::A>(result.value);
         return Status::OK;
@@ -634,7 +634,9 @@ struct gb::CPU::EXE {
     }
 
     // OP_BIT I, r8
-    template <byte_t OP> gb_func static op2(CTX ctx) noexcept->Status {
+    template <byte_t OP>
+        requires((OP & 0b111) != 0b110)
+    gb_func static op2(CTX ctx) noexcept->Status {
         constexpr auto const reg = static_cast<REG8>(OP & 0b111);
         constexpr auto const index = static_cast<byte_t>((OP >> 3) & 0b111);
         constexpr auto const op_bit = static_cast<ALU::OP_BIT>((OP >> 6) & 0b11);
@@ -648,6 +650,23 @@ struct gb::CPU::EXE {
         return Status::OK;
     }
 
+    // OP_BIT I, (HL), address is formed once for the whole read-modify-write
+    template <byte_t OP>
+        requires((OP & 0b111) == 0b110)
+    gb_func static op2(CTX ctx) noexcept->Status {
+        constexpr auto const index = static_cast<byte_t>((OP >> 3) & 0b111);
+        constexpr auto const op_bit = static_cast<ALU::OP_BIT>((OP >> 6) & 0b11);
+        auto const flags = ctx.flags_get();
+        auto const address = ctx.reg16_get<REG16::HL>();
+        auto const lhs = ctx.mem8_get(address);
+        auto const result = ALU::template op_bit<op_bit, index>(flags, lhs);
+        ctx.flags_set(result.flags);
+        if constexpr (op_bit != ALU::OP_BIT::TEST) {
+            ctx.mem8_set(address, result.value);
+        }
+        return Status::OK;
+    }
+
     // BIT OP_BIT I, r8
     template <byte_t OP>
         requires(bit_match(OP, "11001011"))
@@ -656,18 +675,35 @@ struct gb::CPU::EXE {
         return table_op2.ops[op2](ctx);
     }
 
+    using Handler = Status (*)(CTX ctx) noexcept;
+
     struct Table {
-        Status (*const ops[256])(CTX ctx) noexcept;
+        Handler const ops[256];
+    };
+
+    /// Both opcode spaces in one table, 0x100 + op for the 0xCB prefixed ones
+    struct Merged {
+        Handler const ops[512];
     };
 
     static constexpr Table const table_op2 = gb_rep(256, OP, return Table{&EXE::template op2<OP>...};);
 
     static constexpr Table const table_op1 = gb_rep(256, OP, return Table{&EXE::template op1<OP>...};);
 
+    static constexpr Merged const table_ops = gb_rep(
+        512,
+        OP,
+        return Merged{(OP < 0x100 ? &EXE::template op1<static_cast<byte_t>(OP)>
+                                  : &EXE::template op2<static_cast<byte_t>(OP)>)...};);
+
+    /// Prefix is resolved with a well predicted branch so every instruction costs a single indirect call
     gb_func static step(CPU& cpu, BUS& bus) noexcept->Status {
         auto ctx = CTX{cpu, bus};
-        auto const op = ctx.op_fetch8();
-        return table_op1.ops[op](ctx);
+        auto index = static_cast<std::size_t>(ctx.op_fetch8());
+        if (index == 0xCB) {
+            index = 0x100 | ctx.op_fetch8();
+        }
+        return table_ops.ops[index](ctx);
     }
 };
 
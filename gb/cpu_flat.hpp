@@ -0,0 +1,47 @@
+#pragma once
+#include "cpu.hpp"
+#include "cpu_exe.hpp"
+
+/// Flat 64K of RAM with nothing else behind it, bundled with the CPU that runs on it.
+/// Every member is constexpr, so whole programs run inside static_assert and their results can be baked into
+/// constants. cycles counts M-cycles like INFO does.
+struct gb::CPU::FLAT final : BUS {
+    std::array<byte_t, 0x10000> memory = {};
+    std::uint64_t cycles = {};
+    CPU cpu = {};
+    Status status = Status::OK;
+
+    gb_func virtual read_byte(word_t address) noexcept->byte_t override {
+        ++cycles;
+        return memory[address];
+    }
+
+    gb_func virtual write_byte(word_t address, byte_t value) noexcept->void override {
+        ++cycles;
+        memory[address] = value;
+    }
+
+    gb_func virtual waste() noexcept->void override { ++cycles; }
+
+    /// Steps until an instruction returns something other than OK or limit instructions ran, HALT ends a program
+    gb_func run(std::size_t limit) noexcept->Status {
+        for (; limit && status == Status::OK; --limit) {
+            status = EXE::step(cpu, *this);
+        }
+        return status;
+    }
+
+    /// Places program at 0x100 with the stack at the top of memory and runs it
+    template <std::size_t N>
+    gb_func static execute(byte_t const (&program)[N], std::size_t limit = 0x10000) noexcept->FLAT {
+        static_assert(N <= 0x10000 - 0x100);
+        auto flat = FLAT{};
+        for (auto i = std::size_t{}; i != N; ++i) {
+            flat.memory[0x100 + i] = program[i];
+        }
+        flat.cpu.reg_sp = 0xFFFE;
+        flat.cpu.reg_ip = 0x100;
+        flat.run(limit);
+        return flat;
+    }
+};
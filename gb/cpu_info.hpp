@@ -0,0 +1,147 @@
+#pragma once
+#include "cpu.hpp"
+#include "cpu_exe.hpp"
+
+/// Static opcode properties.
+/// Every entry is measured by running the matching op1/op2 handler at compile time against a probing bus, so the
+/// table can never drift from the bit_match patterns in EXE.
+struct gb::CPU::INFO {
+    enum Access : byte_t {
+        NONE = 0,
+        READ = 0x01,    // data read outside of the instruction stream
+        WRITE = 0x02,   // data write
+        HL = 0x04,      // reads or writes (HL)
+        STACK = 0x08,   // pushes or pops
+        BRANCH = 0x10,  // conditional, taken path costs more
+        JUMP = 0x20,    // can move IP somewhere other than the next instruction
+        PREFIX = 0x40,  // 0xCB, real properties live in table_op2
+    };
+
+    struct Op {
+        byte_t length = {};        // bytes including prefix and operands
+        byte_t cycles = {};        // M-cycles, branch not taken
+        byte_t cycles_taken = {};  // M-cycles, branch taken
+        byte_t access = {};        // Access bits
+        Status status = {};
+
+        gb_func inline has(Access flag) const noexcept->bool { return (access & flag) != 0; }
+    };
+
+    struct Table {
+        Op ops[256];
+    };
+
+    /// Records how the handler talks to the bus, operands are non zero so relative jumps do move
+    struct Probe final : BUS {
+        static constexpr word_t start = 0x0100;
+        static constexpr word_t addr_bc = 0xA000;
+        static constexpr word_t addr_de = 0xA100;
+        static constexpr word_t addr_hl = 0xC000;
+        static constexpr word_t addr_sp = 0xD000;
+
+        byte_t code[4] = {};
+        byte_t fetched = {};
+        byte_t cycles = {};
+        byte_t access = {};
+
+        gb_func static near(word_t address, word_t base) noexcept->bool {
+            return address >= base - 2 && address <= base + 1;
+        }
+
+        gb_func touch(word_t address, Access kind) noexcept->void {
+            access |= kind;
+            if (address == addr_hl) {
+                access |= HL;
+            } else if (near(address, addr_sp)) {
+                access |= STACK;
+            }
+        }
+
+        gb_func virtual read_byte(word_t address) noexcept->byte_t override {
+            ++cycles;
+            if (fetched < 4 && address == start + fetched) {
+                return code[fetched++];
+            }
+            touch(address, READ);
+            return 0;
+        }
+
+        gb_func virtual write_byte(word_t address, byte_t) noexcept->void override {
+            ++cycles;
+            touch(address, WRITE);
+        }
+
+        gb_func virtual waste() noexcept->void override { ++cycles; }
+    };
+
+    gb_func static probe(byte_t op0, byte_t op1, bool flags) noexcept->Op {
+        auto cpu = CPU{};
+        cpu.reg_b = addr_byte(Probe::addr_bc, 1), cpu.reg_c = addr_byte(Probe::addr_bc, 0);
+        cpu.reg_d = addr_byte(Probe::addr_de, 1), cpu.reg_e = addr_byte(Probe::addr_de, 0);
+        cpu.reg_h = addr_byte(Probe::addr_hl, 1), cpu.reg_l = addr_byte(Probe::addr_hl, 0);
+        cpu.reg_sp = Probe::addr_sp;
+        cpu.reg_ip = Probe::start;
+        cpu.reg_f = Flags{flags, flags, flags, flags};
+        auto bus = Probe{};
+        bus.code[0] = op0;
+        bus.code[1] = op1;
+        bus.code[2] = 0x10;
+        bus.code[3] = 0x10;
+        auto result = Op{};
+        result.status = EXE::step(cpu, bus);
+        result.length = bus.fetched;
+        result.cycles = bus.cycles;
+        result.cycles_taken = bus.cycles;
+        result.access = bus.access;
+        if (cpu.reg_ip != Probe::start + bus.fetched) {
+            result.access |= JUMP;
+        }
+        return result;
+    }
+
+    gb_func static addr_byte(word_t address, int index) noexcept->byte_t {
+        return static_cast<byte_t>(address >> (index * 8));
+    }
+
+    /// Conditions are either satisfied with all flags clear or with all flags set, so two runs cover both paths
+    gb_func static measure(byte_t op0, byte_t op1) noexcept->Op {
+        auto const clear = probe(op0, op1, false);
+        auto const set = probe(op0, op1, true);
+        auto result = clear.cycles <= set.cycles ? clear : set;
+        result.access = clear.access | set.access;
+        if (clear.cycles != set.cycles) {
+            result.cycles_taken = clear.cycles <= set.cycles ? set.cycles : clear.cycles;
+            result.access |= BRANCH;
+        }
+        if (op0 == 0xCB) {
+            result.access |= PREFIX;
+        }
+        return result;
+    }
+
+    static Table const table_op1;
+
+    static Table const table_op2;
+
+    /// Properties of the instruction starting with op0, op1 only matters after the 0xCB prefix
+    gb_func static decode(byte_t op0, byte_t op1) noexcept->Op const& {
+        return op0 == 0xCB ? table_op2.ops[op1] : table_op1.ops[op0];
+    }
+};
+
+/// Handlers have to be complete before they can be run, so the tables are filled in after the class
+constexpr gb::CPU::INFO::Table const gb::CPU::INFO::table_op1 =
+    gb_rep(256, OP, return Table{measure(OP, 0x00)...};);
+
+constexpr gb::CPU::INFO::Table const gb::CPU::INFO::table_op2 =
+    gb_rep(256, OP, return Table{measure(0xCB, OP)...};);
+
+static_assert(gb::CPU::INFO::decode(0x00, 0).length == 1 && gb::CPU::INFO::decode(0x00, 0).cycles == 1);
+static_assert(gb::CPU::INFO::decode(0xC3, 0).length == 3 && gb::CPU::INFO::decode(0xC3, 0).cycles == 4);
+static_assert(gb::CPU::INFO::decode(0xC4, 0).cycles == 3 && gb::CPU::INFO::decode(0xC4, 0).cycles_taken == 6);
+static_assert(gb::CPU::INFO::decode(0x20, 0).has(gb::CPU::INFO::BRANCH));
+static_assert(gb::CPU::INFO::decode(0x34, 0).cycles == 3 && gb::CPU::INFO::decode(0x34, 0).has(gb::CPU::INFO::HL));
+static_assert(gb::CPU::INFO::decode(0xCB, 0x46).length == 2 && gb::CPU::INFO::decode(0xCB, 0x46).cycles == 3);
+static_assert(gb::CPU::INFO::decode(0xCB, 0x86).cycles == 4);
+static_assert(gb::CPU::INFO::decode(0xF5, 0).has(gb::CPU::INFO::STACK));
+static_assert(!gb::CPU::INFO::decode(0x46, 0).has(gb::CPU::INFO::WRITE));
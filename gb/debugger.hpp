@@ -0,0 +1,134 @@
+#pragma once
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+#include "cpu.hpp"
+
+/// Breakpoints and watchpoints.
+/// Every point marks its 256 byte pages in a bitmap, exact matching and conditions only run for accesses that land on
+/// a marked page. MCB1 only switches to a bus that tests the read and write bitmaps while such points exist, and only
+/// tests the execution bitmap before each instruction while an execution point exists, so the plain path stays as is.
+struct gb::Debugger final {
+    enum class Kind : byte_t {
+        EXEC = 0x01,
+        READ = 0x02,
+        WRITE = 0x04,
+    };
+
+    /// Evaluated after address match, point only triggers when it returns true
+    using Condition = std::function<bool(CPU const& cpu, CPU::MCB1& mem)>;
+
+    struct Point {
+        int id = {};
+        Kind kind = {};
+        word_t first = {};
+        word_t last = {};
+        int bank = -1;  // ROM bank for 0x4000 - 0x7FFF, -1 matches any
+        Condition condition = {};
+        std::uint64_t hits = {};
+    };
+
+    struct Hit {
+        int id = {};
+        Kind kind = {};
+        word_t address = {};
+        byte_t value = {};
+    };
+
+    struct Pages {
+        std::uint64_t bits[4] = {};
+
+        gb_func test(word_t address) const noexcept->bool { return (bits[address >> 14] >> ((address >> 8) & 63)) & 1; }
+
+        gb_func any() const noexcept->bool { return (bits[0] | bits[1] | bits[2] | bits[3]) != 0; }
+
+        gb_func set(word_t first, word_t last) noexcept->void {
+            for (auto page = first >> 8; page <= last >> 8; ++page) {
+                bits[page >> 6] |= std::uint64_t{1} << (page & 63);
+            }
+        }
+    };
+
+    std::vector<Point> points = {};
+    Pages exec_pages = {};
+    Pages read_pages = {};
+    Pages write_pages = {};
+    int next_id = 1;
+
+    /// Set when a point triggered, run() stops at the end of that instruction
+    bool triggered = {};
+    Hit hit = {};
+
+    /// Resuming from an execution breakpoint must not hit it again before the instruction ran
+    bool step_over = {};
+
+    CPU const* cpu = {};
+
+    auto armed() const noexcept -> bool { return !points.empty(); }
+
+    auto add(Kind kind, word_t first, word_t last, int bank = -1, Condition condition = {}) -> int {
+        points.push_back({next_id, kind, first, std::max(first, last), bank, std::move(condition)});
+        rebuild();
+        return next_id++;
+    }
+
+    auto add_breakpoint(word_t address, int bank = -1, Condition condition = {}) -> int {
+        return add(Kind::EXEC, address, address, bank, std::move(condition));
+    }
+
+    auto remove(int id) -> bool {
+        auto const count = std::erase_if(points, [id](auto const& point) { return point.id == id; });
+        rebuild();
+        return count != 0;
+    }
+
+    auto clear() noexcept -> void {
+        points.clear();
+        rebuild();
+    }
+
+    auto rebuild() noexcept -> void {
+        exec_pages = read_pages = write_pages = {};
+        for (auto const& point : points) {
+            auto& pages = point.kind == Kind::EXEC ? exec_pages : point.kind == Kind::READ ? read_pages : write_pages;
+            pages.set(point.first, point.last);
+        }
+    }
+
+    /// Slow path, address is known to be on a marked page
+    auto match(Kind kind, word_t address, byte_t value, byte_t bank, CPU::MCB1& mem) -> bool {
+        for (auto& point : points) {
+            if (point.kind != kind || address < point.first || address > point.last) {
+                continue;
+            }
+            if (point.bank >= 0 && address >= 0x4000 && address < 0x8000 && point.bank != bank) {
+                continue;
+            }
+            if (point.condition && !point.condition(*cpu, mem)) {
+                continue;
+            }
+            ++point.hits;
+            triggered = true;
+            hit = {point.id, kind, address, value};
+            return true;
+        }
+        return false;
+    }
+
+    auto exec(CPU const& state, byte_t bank, CPU::MCB1& mem) -> bool {
+        if (step_over) {
+            step_over = false;
+            return false;
+        }
+        if (!exec_pages.test(state.reg_ip)) {
+            return false;
+        }
+        cpu = &state;
+        if (match(Kind::EXEC, state.reg_ip, 0, bank, mem)) {
+            step_over = true;
+            return true;
+        }
+        return false;
+    }
+};
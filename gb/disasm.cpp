@@ -0,0 +1,197 @@
+#include "disasm.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+#include <memory>
+
+using namespace gb;
+
+namespace {
+    constexpr char hex_digits[] = "0123456789ABCDEF";
+
+    /// Names are clipped so one line always fits in 256 bytes
+    constexpr std::size_t max_name = 64;
+
+    auto put(char* out, std::string_view text) noexcept -> char* { return std::copy(text.begin(), text.end(), out); }
+
+    auto put_hex(char* out, unsigned value, int digits) noexcept -> char* {
+        for (auto i = digits - 1; i >= 0; --i) {
+            *out++ = hex_digits[(value >> (i * 4)) & 0xF];
+        }
+        return out;
+    }
+}
+
+auto Disasm::load_symbols(char const* filename) -> bool {
+    auto file = std::ifstream(filename);
+    if (!file) {
+        return false;
+    }
+    auto line = std::string{};
+    while (std::getline(file, line)) {
+        auto text = std::string_view(line);
+        text = text.substr(0, text.find(';'));
+        auto const colon = text.find(':');
+        auto const space = text.find(' ', colon);
+        if (colon == text.npos || space == text.npos) {
+            continue;
+        }
+        auto bank = 0u;
+        auto address = 0u;
+        auto const end = text.data() + text.size();
+        if (std::from_chars(text.data(), text.data() + colon, bank, 16).ec != std::errc{} ||
+            std::from_chars(text.data() + colon + 1, text.data() + space, address, 16).ec != std::errc{}) {
+            continue;
+        }
+        auto name = std::string_view(text.data() + space + 1, end);
+        while (!name.empty() && (name.back() == '\r' || name.back() == ' ')) {
+            name.remove_suffix(1);
+        }
+        if (!name.empty()) {
+            symbols.push_back({key(bank, static_cast<word_t>(address)), std::string(name)});
+        }
+    }
+    std::stable_sort(symbols.begin(), symbols.end(), [](auto const& l, auto const& r) { return l.key < r.key; });
+    return true;
+}
+
+auto Disasm::symbol(std::uint32_t bank, word_t address) const noexcept -> Symbol const* {
+    auto const k = key(bank, address);
+    auto const i = std::lower_bound(symbols.begin(), symbols.end(), k, [](auto const& s, auto k) { return s.key < k; });
+    return i != symbols.end() && i->key == k ? &*i : nullptr;
+}
+
+auto Disasm::symbol_near(std::uint32_t bank, word_t address) const noexcept -> Symbol const* {
+    auto const k = key(bank, address);
+    auto const i = std::upper_bound(symbols.begin(), symbols.end(), k, [](auto k, auto const& s) { return k < s.key; });
+    if (i == symbols.begin() || ((i - 1)->key >> 16) != (k >> 16)) {
+        return nullptr;
+    }
+    return &*(i - 1);
+}
+
+auto Disasm::format(char* out, std::uint32_t bank, word_t address, byte_t const* code) const noexcept -> char* {
+    auto const& text = code[0] == 0xCB ? table_op2.ops[code[1]] : table_op1.ops[code[0]];
+    auto const length = CPU::INFO::decode(code[0], code[1]).length;
+    auto const put_address = [&](char* out, word_t target) {
+        if (auto const s = symbol(bank, target)) {
+            return put(out, std::string_view(s->name).substr(0, max_name));
+        }
+        *out++ = '$';
+        return put_hex(out, target, 4);
+    };
+    for (auto c : text.view()) {
+        switch (c) {
+            case '#':
+                *out++ = '$';
+                out = put_hex(out, code[1], 2);
+                break;
+            case '@':
+                out = put_address(out, word_pack(code[1], code[2]));
+                break;
+            case '~':
+                out = put_address(out, static_cast<word_t>(address + length + static_cast<sbyte_t>(code[1])));
+                break;
+            case '%': {
+                auto const disp = static_cast<sbyte_t>(code[1]);
+                *out++ = disp < 0 ? '-' : '+';
+                *out++ = '$';
+                out = put_hex(out, static_cast<unsigned>(disp < 0 ? -disp : disp), 2);
+                break;
+            }
+            default:
+                *out++ = c;
+        }
+    }
+    return out;
+}
+
+auto Disasm::disassemble_bank(FILE* out, byte_t const* rom, std::size_t size, std::uint32_t bank) const -> void {
+    auto const base = static_cast<std::size_t>(bank) * 0x4000;
+    if (base >= size) {
+        return;
+    }
+    auto const end = std::min<std::size_t>(base + 0x4000, size);
+    auto const origin = bank ? 0x4000u : 0u;
+    auto buffer = std::string{};
+    buffer.reserve(0x4000 * 48);
+    char line[256];
+    for (auto offset = base; offset < end;) {
+        auto const address = static_cast<word_t>(origin + offset - base);
+        byte_t code[3] = {};
+        std::copy(rom + offset, rom + std::min(offset + 3, end), code);
+        auto length = static_cast<std::size_t>(CPU::INFO::decode(code[0], code[1]).length);
+        if (auto const s = symbol(bank, address)) {
+            buffer.append(s->name).append(":\n");
+        }
+        auto cur = put(line, "    ");
+        cur = put_hex(cur, bank, 2);
+        *cur++ = ':';
+        cur = put_hex(cur, address, 4);
+        *cur++ = ' ';
+        if (offset + length > end) {
+            // Instruction runs past the end of the bank, show the remaining bytes as data
+            length = 1;
+            cur = put(cur, "          DB $");
+            cur = put_hex(cur, code[0], 2);
+        } else {
+            for (std::size_t i = 0; i != 3; ++i) {
+                if (i < length) {
+                    cur = put_hex(cur, code[i], 2);
+                    *cur++ = ' ';
+                } else {
+                    cur = put(cur, "   ");
+                }
+            }
+            *cur++ = ' ';
+            cur = format(cur, bank, address, code);
+        }
+        *cur++ = '\n';
+        buffer.append(line, cur);
+        offset += length;
+    }
+    fwrite(buffer.data(), 1, buffer.size(), out);
+}
+
+auto Disasm::annotate(FILE* out, FILE* in) const -> std::size_t {
+    constexpr std::size_t batch = 1 << 16;
+    auto const records = std::make_unique<Record[]>(batch);
+    auto const text = std::make_unique<char[]>(batch * 256);
+    auto total = std::size_t{};
+    while (auto const count = fread(records.get(), sizeof(Record), batch, in)) {
+        auto cur = text.get();
+        for (std::size_t i = 0; i != count; ++i) {
+            auto const& r = records[i];
+            auto const reg = [&](char const* name, unsigned value, int digits) {
+                cur = put(cur, name);
+                cur = put_hex(cur, value, digits);
+            };
+            reg("A:", r.a, 2);
+            reg(" F:", r.f, 2);
+            reg(" B:", r.b, 2);
+            reg(" C:", r.c, 2);
+            reg(" D:", r.d, 2);
+            reg(" E:", r.e, 2);
+            reg(" H:", r.h, 2);
+            reg(" L:", r.l, 2);
+            reg(" SP:", r.sp, 4);
+            reg(" PC:", r.bank, 2);
+            reg(":", r.pc, 4);
+            *cur++ = ' ';
+            if (auto const s = symbol_near(r.bank, r.pc)) {
+                cur = put(cur, std::string_view(s->name).substr(0, max_name));
+                if (auto const offset = r.pc - (s->key & 0xFFFF)) {
+                    cur = put(cur, "+$");
+                    cur = put_hex(cur, offset, 4);
+                }
+                *cur++ = ' ';
+            }
+            cur = format(cur, r.bank, r.pc, r.code);
+            *cur++ = '\n';
+        }
+        fwrite(text.get(), 1, static_cast<std::size_t>(cur - text.get()), out);
+        total += count;
+    }
+    return total;
+}
@@ -0,0 +1,229 @@
+#pragma once
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "cpu_info.hpp"
+
+/// Table driven disassembler with RGBDS symbol support.
+/// Mnemonics are built at compile time from the same bit_match patterns as EXE, operands are left as markers that
+/// format() fills in: '#' u8, '@' u16, '~' i8 jump target, '%' signed i8.
+struct gb::Disasm final {
+    struct Text {
+        char data[15] = {};
+        byte_t size = {};
+
+        gb_func add(char const* text) noexcept->Text& {
+            while (*text) {
+                data[size++] = *text++;
+            }
+            return *this;
+        }
+
+        gb_func add(char c) noexcept->Text& {
+            data[size++] = c;
+            return *this;
+        }
+
+        constexpr auto view() const noexcept -> std::string_view { return {data, size}; }
+    };
+
+    struct Table {
+        Text ops[256];
+    };
+
+    static constexpr char const* reg8[8] = {"B", "C", "D", "E", "H", "L", "(HL)", "A"};
+    static constexpr char const* reg16[4] = {"BC", "DE", "HL", "SP"};
+    static constexpr char const* reg16_stack[4] = {"BC", "DE", "HL", "AF"};
+    static constexpr char const* cond[4] = {"NZ", "Z", "NC", "C"};
+    static constexpr char const* op_bin[8] = {"ADD A,", "ADC A,", "SUB ", "SBC A,", "AND ", "XOR ", "OR ", "CP "};
+    static constexpr char const* op_rot_a[4] = {"RLCA", "RRCA", "RLA", "RRA"};
+    static constexpr char const* op_rot[8] = {"RLC ", "RRC ", "RL ", "RR ", "SLA ", "SRA ", "SWAP ", "SRL "};
+    static constexpr char const* op_bit[4] = {"", "BIT ", "RES ", "SET "};
+
+    gb_func static name1(byte_t op) noexcept->Text {
+        auto r = Text{};
+        auto const y = (op >> 3) & 0b111;
+        auto const z = op & 0b111;
+        auto const p = (op >> 4) & 0b11;
+        auto const cc = (op >> 3) & 0b11;
+        if (one_of(op, 0xD3, 0xDB, 0xDD, 0xE3, 0xE4, 0xEB, 0xEC, 0xED, 0xF4, 0xFC, 0xFD)) {
+            r.add("DB $").add("0123456789ABCDEF"[op >> 4]).add("0123456789ABCDEF"[op & 0xF]);
+        } else if (bit_match(op, "00000000")) {
+            r.add("NOP");
+        } else if (bit_match(op, "00010000")) {
+            r.add("STOP");
+        } else if (bit_match(op, "11110011")) {
+            r.add("DI");
+        } else if (bit_match(op, "11111011")) {
+            r.add("EI");
+        } else if (bit_match(op, "00001000")) {
+            r.add("LD (@),SP");
+        } else if (bit_match(op, "00rr0001")) {
+            r.add("LD ").add(reg16[p]).add(",@");
+        } else if (bit_match(op, "000r0010")) {
+            r.add("LD (").add(reg16[p]).add("),A");
+        } else if (bit_match(op, "000r1010")) {
+            r.add("LD A,(").add(reg16[p]).add(")");
+        } else if (bit_match(op, "00100010")) {
+            r.add("LD (HL+),A");
+        } else if (bit_match(op, "00101010")) {
+            r.add("LD A,(HL+)");
+        } else if (bit_match(op, "00110010")) {
+            r.add("LD (HL-),A");
+        } else if (bit_match(op, "00111010")) {
+            r.add("LD A,(HL-)");
+        } else if (bit_match(op, "00reg110")) {
+            r.add("LD ").add(reg8[y]).add(",#");
+        } else if (bit_match(op, "01110110")) {
+            r.add("HALT");
+        } else if (bit_match(op, "01regreg")) {
+            r.add("LD ").add(reg8[y]).add(',').add(reg8[z]);
+        } else if (bit_match(op, "11100000")) {
+            r.add("LDH ($FF00+#),A");
+        } else if (bit_match(op, "11110000")) {
+            r.add("LDH A,($FF00+#)");
+        } else if (bit_match(op, "11100010")) {
+            r.add("LD ($FF00+C),A");
+        } else if (bit_match(op, "11110010")) {
+            r.add("LD A,($FF00+C)");
+        } else if (bit_match(op, "11101010")) {
+            r.add("LD (@),A");
+        } else if (bit_match(op, "11111010")) {
+            r.add("LD A,(@)");
+        } else if (bit_match(op, "11111000")) {
+            r.add("LD HL,SP%");
+        } else if (bit_match(op, "11101000")) {
+            r.add("ADD SP,%");
+        } else if (bit_match(op, "11111001")) {
+            r.add("LD SP,HL");
+        } else if (bit_match(op, "11rr0001")) {
+            r.add("POP ").add(reg16_stack[p]);
+        } else if (bit_match(op, "11rr0101")) {
+            r.add("PUSH ").add(reg16_stack[p]);
+        } else if (bit_match(op, "00011000")) {
+            r.add("JR ~");
+        } else if (bit_match(op, "001cc000")) {
+            r.add("JR ").add(cond[cc]).add(",~");
+        } else if (bit_match(op, "11000011")) {
+            r.add("JP @");
+        } else if (bit_match(op, "110cc010")) {
+            r.add("JP ").add(cond[cc]).add(",@");
+        } else if (bit_match(op, "11101001")) {
+            r.add("JP HL");
+        } else if (bit_match(op, "11001001")) {
+            r.add("RET");
+        } else if (bit_match(op, "11011001")) {
+            r.add("RETI");
+        } else if (bit_match(op, "110cc000")) {
+            r.add("RET ").add(cond[cc]);
+        } else if (bit_match(op, "11001101")) {
+            r.add("CALL @");
+        } else if (bit_match(op, "110cc100")) {
+            r.add("CALL ").add(cond[cc]).add(",@");
+        } else if (bit_match(op, "11rst111")) {
+            r.add("RST $").add("0123456789ABCDEF"[(op & 0x38) >> 4]).add("08"[(op >> 3) & 1]);
+        } else if (bit_match(op, "00rr0011")) {
+            r.add("INC ").add(reg16[p]);
+        } else if (bit_match(op, "00rr1011")) {
+            r.add("DEC ").add(reg16[p]);
+        } else if (bit_match(op, "00reg100")) {
+            r.add("INC ").add(reg8[y]);
+        } else if (bit_match(op, "00reg101")) {
+            r.add("DEC ").add(reg8[y]);
+        } else if (bit_match(op, "00rr1001")) {
+            r.add("ADD HL,").add(reg16[p]);
+        } else if (bit_match(op, "10binreg")) {
+            r.add(op_bin[y]).add(reg8[z]);
+        } else if (bit_match(op, "11bin110")) {
+            r.add(op_bin[y]).add('#');
+        } else if (bit_match(op, "000xx111")) {
+            r.add(op_rot_a[y]);
+        } else if (bit_match(op, "00100111")) {
+            r.add("DAA");
+        } else if (bit_match(op, "00101111")) {
+            r.add("CPL");
+        } else if (bit_match(op, "00110111")) {
+            r.add("SCF");
+        } else if (bit_match(op, "00111111")) {
+            r.add("CCF");
+        } else if (bit_match(op, "11001011")) {
+            r.add("PREFIX CB");
+        }
+        return r;
+    }
+
+    gb_func static name2(byte_t op) noexcept->Text {
+        auto r = Text{};
+        auto const group = op >> 6;
+        auto const y = (op >> 3) & 0b111;
+        if (group == 0) {
+            r.add(op_rot[y]);
+        } else {
+            r.add(op_bit[group]).add(static_cast<char>('0' + y)).add(',');
+        }
+        return r.add(reg8[op & 0b111]);
+    }
+
+    static Table const table_op1;
+
+    static Table const table_op2;
+
+    /// One record per executed instruction, written by the emulator and annotated offline
+    struct Record {
+        word_t pc = {};
+        word_t sp = {};
+        byte_t bank = {};
+        byte_t a = {};
+        byte_t f = {};
+        byte_t b = {};
+        byte_t c = {};
+        byte_t d = {};
+        byte_t e = {};
+        byte_t h = {};
+        byte_t l = {};
+        byte_t code[3] = {};
+    };
+
+    struct Symbol {
+        std::uint32_t key = {};  // bank << 16 | address
+        std::string name = {};
+    };
+
+    /// Sorted by key
+    std::vector<Symbol> symbols = {};
+
+    gb_func static key(std::uint32_t bank, word_t address) noexcept->std::uint32_t {
+        // ROM0, VRAM, WRAM0 and HRAM symbols are emitted with bank 0 by RGBLINK
+        return (address >= 0x4000 && address < 0x8000 ? bank << 16 : 0) | address;
+    }
+
+    /// Loads a RGBDS .sym file ("BB:AAAA Name" per line, ';' starts a comment), returns false if it can not be read
+    auto load_symbols(char const* filename) -> bool;
+
+    /// Exact symbol at address or nullptr
+    auto symbol(std::uint32_t bank, word_t address) const noexcept -> Symbol const*;
+
+    /// Closest symbol at or below address in the same bank or nullptr
+    auto symbol_near(std::uint32_t bank, word_t address) const noexcept -> Symbol const*;
+
+    /// Writes the instruction at address into out and returns the end of the written text
+    auto format(char* out, std::uint32_t bank, word_t address, byte_t const* code) const noexcept -> char*;
+
+    /// Linear sweep over one 16 KiB bank of rom
+    auto disassemble_bank(FILE* out, byte_t const* rom, std::size_t size, std::uint32_t bank) const -> void;
+
+    /// Converts a file of Records into text, returns the number of records
+    auto annotate(FILE* out, FILE* in) const -> std::size_t;
+};
+
+constexpr gb::Disasm::Table const gb::Disasm::table_op1 = gb_rep(256, OP, return Table{name1(OP)...};);
+
+constexpr gb::Disasm::Table const gb::Disasm::table_op2 = gb_rep(256, OP, return Table{name2(OP)...};);
+
+static_assert(sizeof(gb::Disasm::Record) == 16);
+static_assert(gb::Disasm::table_op1.ops[0xC3].view() == "JP @");
+static_assert(gb::Disasm::table_op1.ops[0xE6].view() == "AND #");
+static_assert(gb::Disasm::table_op1.ops[0xFF].view() == "RST $38");
+static_assert(gb::Disasm::table_op2.ops[0x7E].view() == "BIT 7,(HL)");
@@ -0,0 +1,434 @@
+#include "gdb.hpp"
+
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+
+using namespace gb;
+
+namespace {
+    constexpr char hex_digits[] = "0123456789abcdef";
+
+    auto put_hex8(std::string& out, unsigned value) -> void {
+        out.push_back(hex_digits[(value >> 4) & 0xF]);
+        out.push_back(hex_digits[value & 0xF]);
+    }
+
+    auto put_hex16(std::string& out, unsigned value) -> void {
+        put_hex8(out, value & 0xFF);
+        put_hex8(out, value >> 8);
+    }
+
+    auto parse_hex(std::string_view& text) -> unsigned {
+        auto value = 0u;
+        auto const [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), value, 16);
+        text.remove_prefix(static_cast<std::size_t>(ptr - text.data()));
+        if (!text.empty() && (text.front() == ',' || text.front() == ':' || text.front() == '=')) {
+            text.remove_prefix(1);
+        }
+        return value;
+    }
+
+    auto get_hex16(std::string_view text, std::size_t index) -> word_t {
+        auto lo = 0u;
+        auto hi = 0u;
+        std::from_chars(text.data() + index * 4, text.data() + index * 4 + 2, lo, 16);
+        std::from_chars(text.data() + index * 4 + 2, text.data() + index * 4 + 4, hi, 16);
+        return word_pack(static_cast<byte_t>(lo), static_cast<byte_t>(hi));
+    }
+}
+
+GDB::~GDB() {
+    stop();
+    mem.debugger = previous;
+}
+
+auto GDB::listen(char const* where) -> bool {
+    stop();
+    if (std::strchr(where, '/')) {
+        auto address = sockaddr_un{};
+        address.sun_family = AF_UNIX;
+        std::strncpy(address.sun_path, where, sizeof(address.sun_path) - 1);
+        ::unlink(where);
+        listen_fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listen_fd < 0 || ::bind(listen_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+            stop();
+            return false;
+        }
+    } else {
+        auto address = sockaddr_in{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(static_cast<std::uint16_t>(std::atoi(where)));
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        listen_fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        if (listen_fd < 0) {
+            return false;
+        }
+        auto const reuse = 1;
+        ::setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        if (::bind(listen_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+            stop();
+            return false;
+        }
+    }
+    if (::listen(listen_fd, 1) != 0) {
+        stop();
+        return false;
+    }
+    replied.store(false, std::memory_order_relaxed);
+    running.store(true, std::memory_order_relaxed);
+    thread = std::thread([this] { client(); });
+    return true;
+}
+
+auto GDB::stop() noexcept -> void {
+    running.store(false, std::memory_order_relaxed);
+    // Wake the stub if it waits for a reply the emulation thread will never post
+    replied.store(true, std::memory_order_release);
+    replied.notify_one();
+    if (thread.joinable()) {
+        thread.join();
+    }
+    if (listen_fd >= 0) {
+        ::close(listen_fd);
+        listen_fd = -1;
+    }
+}
+
+auto GDB::run(std::uint64_t until) -> CPU::Status {
+    while (mem.cycles < until) {
+        if (halted || pending.load(std::memory_order_acquire)) {
+            serve();
+            if (killed) {
+                return CPU::Status::STOP;
+            }
+            continue;
+        }
+        auto const end = stepping ? mem.cycles + 1 : std::min(until, mem.cycles + slice_cycles);
+        auto const status = mem.run(cpu, end);
+        if (status == CPU::Status::BAD) {
+            stopped(4);
+        } else if (status != CPU::Status::OK || stepping) {
+            stopped(5, status == CPU::Status::BREAK && debugger.triggered);
+        }
+    }
+    return CPU::Status::OK;
+}
+
+auto GDB::serve() -> void {
+    if (!running.load(std::memory_order_relaxed) && !pending.load(std::memory_order_acquire)) {
+        // Nobody will ever answer, keep running without the debugger
+        halted = false;
+        return;
+    }
+    pending.wait(false, std::memory_order_acquire);
+    auto const packet = std::move(request);
+    request.clear();
+    pending.store(false, std::memory_order_release);
+    handle(packet);
+}
+
+auto GDB::stopped(int signal, bool watch) -> void {
+    halted = true;
+    stepping = false;
+    auto const& hit = debugger.hit;
+    watch &= hit.kind != Debugger::Kind::EXEC;
+    auto text = std::string{watch ? "T" : "S"};
+    put_hex8(text, static_cast<unsigned>(signal));
+    if (watch) {
+        // Access points were set by Z4 as a read and a write point under the same type
+        auto const access = std::any_of(mappings.begin(), mappings.end(), [&](Mapping const& mapping) {
+            return mapping.id == hit.id && mapping.type == '4';
+        });
+        text += access ? "awatch:" : hit.kind == Debugger::Kind::READ ? "rwatch:" : "watch:";
+        char digits[4];
+        auto const [end, ec] = std::to_chars(digits, digits + sizeof(digits), hit.address, 16);
+        text.append(digits, end);
+        text += ';';
+    }
+    stop_reply = text;
+    post_reply(std::move(text));
+}
+
+auto GDB::post_reply(std::string text) -> void {
+    reply = std::move(text);
+    replied.store(true, std::memory_order_release);
+    replied.notify_one();
+}
+
+auto GDB::get_register(unsigned index) const noexcept -> word_t {
+    switch (index) {
+        case 0:
+            return word_pack(cpu.reg_f.into_byte(), cpu.reg_a);
+        case 1:
+            return word_pack(cpu.reg_c, cpu.reg_b);
+        case 2:
+            return word_pack(cpu.reg_e, cpu.reg_d);
+        case 3:
+            return word_pack(cpu.reg_l, cpu.reg_h);
+        case 4:
+            return cpu.reg_sp;
+        case 5:
+            return cpu.reg_ip;
+    }
+    return 0;
+}
+
+auto GDB::set_register(unsigned index, word_t value) noexcept -> void {
+    auto const [lo, hi] = word_unpack(value);
+    switch (index) {
+        case 0:
+            cpu.reg_a = hi;
+            cpu.reg_f = CPU::Flags::from_byte(lo);
+            break;
+        case 1:
+            cpu.reg_b = hi;
+            cpu.reg_c = lo;
+            break;
+        case 2:
+            cpu.reg_d = hi;
+            cpu.reg_e = lo;
+            break;
+        case 3:
+            cpu.reg_h = hi;
+            cpu.reg_l = lo;
+            break;
+        case 4:
+            cpu.reg_sp = value;
+            break;
+        case 5:
+            cpu.reg_ip = value;
+            break;
+    }
+}
+
+auto GDB::handle(std::string const& packet) -> void {
+    if (packet.empty()) {
+        return post_reply({});
+    }
+    auto args = std::string_view(packet).substr(1);
+    auto out = std::string{};
+    switch (packet[0]) {
+        case '\x03':
+            if (!halted) {
+                stopped(2);
+            }
+            return;
+        case '\x04':
+            // Connection lost, nobody is waiting for a reply
+            forget();
+            halted = false;
+            stepping = false;
+            return;
+        case '?':
+            return post_reply(stop_reply);
+        case 'g':
+            for (unsigned index = 0; index != 6; ++index) {
+                put_hex16(out, get_register(index));
+            }
+            return post_reply(std::move(out));
+        case 'G':
+            if (args.size() < 24) {
+                return post_reply("E01");
+            }
+            for (unsigned index = 0; index != 6; ++index) {
+                set_register(index, get_hex16(args, index));
+            }
+            return post_reply("OK");
+        case 'p':
+            put_hex16(out, get_register(parse_hex(args)));
+            return post_reply(std::move(out));
+        case 'P': {
+            auto const index = parse_hex(args);
+            if (index >= 6) {
+                return post_reply("E01");
+            }
+            set_register(index, get_hex16(args, 0));
+            return post_reply("OK");
+        }
+        case 'm': {
+            auto address = parse_hex(args);
+            auto const length = parse_hex(args);
+            for (auto i = 0u; i != length; ++i) {
+                put_hex8(out, mem.peek(static_cast<word_t>(address++)));
+            }
+            return post_reply(std::move(out));
+        }
+        case 'M': {
+            auto address = parse_hex(args);
+            auto const length = parse_hex(args);
+            for (auto i = 0u; i != length && args.size() >= 2; ++i) {
+                auto value = 0u;
+                std::from_chars(args.data(), args.data() + 2, value, 16);
+                mem.poke(static_cast<word_t>(address++), static_cast<byte_t>(value));
+                args.remove_prefix(2);
+            }
+            return post_reply("OK");
+        }
+        case 'c':
+        case 's':
+            if (!args.empty()) {
+                cpu.reg_ip = static_cast<word_t>(parse_hex(args));
+            }
+            halted = false;
+            stepping = packet[0] == 's';
+            return;
+        case 'Z':
+        case 'z': {
+            auto const type = args.empty() ? '?' : args[0];
+            args.remove_prefix(std::min<std::size_t>(args.size(), 2));
+            auto const address = static_cast<word_t>(parse_hex(args));
+            // Kind is the watched length for Z2 - Z4, breakpoints always cover one instruction
+            auto const length = type < '2' ? 1u : std::clamp(parse_hex(args), 1u, 0x10000u - address);
+            if (type < '0' || type > '4') {
+                return post_reply({});
+            }
+            auto const last = static_cast<word_t>(address + length - 1);
+            if (packet[0] == 'z') {
+                std::erase_if(mappings, [&](Mapping const& mapping) {
+                    if (mapping.type != type || mapping.address != address || mapping.length != length) {
+                        return false;
+                    }
+                    debugger.remove(mapping.id);
+                    return true;
+                });
+                return post_reply("OK");
+            }
+            if (type == '0' || type == '1') {
+                mappings.push_back({type, address, length, debugger.add_breakpoint(address)});
+            }
+            if (type == '2' || type == '4') {
+                mappings.push_back({type, address, length, debugger.add(Debugger::Kind::WRITE, address, last)});
+            }
+            if (type == '3' || type == '4') {
+                mappings.push_back({type, address, length, debugger.add(Debugger::Kind::READ, address, last)});
+            }
+            return post_reply("OK");
+        }
+        case 'D':
+            forget();
+            halted = false;
+            return post_reply("OK");
+        case 'k':
+            killed = true;
+            return;
+        case 'H':
+            return post_reply("OK");
+        case 'q':
+            if (args.starts_with("Supported")) {
+                return post_reply("PacketSize=1000");
+            } else if (args.starts_with("Attached")) {
+                return post_reply("1");
+            } else if (args.starts_with("C")) {
+                return post_reply("QC1");
+            } else if (args.starts_with("fThreadInfo")) {
+                return post_reply("m1");
+            } else if (args.starts_with("sThreadInfo")) {
+                return post_reply("l");
+            }
+            return post_reply({});
+        default:
+            return post_reply({});
+    }
+}
+
+auto GDB::forget() -> void {
+    for (auto const& mapping : mappings) {
+        debugger.remove(mapping.id);
+    }
+    mappings.clear();
+}
+
+auto GDB::send_packet(std::string const& text) -> bool {
+    auto checksum = 0u;
+    for (auto c : text) {
+        checksum += static_cast<byte_t>(c);
+    }
+    auto packet = "$" + text + "#";
+    put_hex8(packet, checksum & 0xFF);
+    return ::send(client_fd, packet.data(), packet.size(), MSG_NOSIGNAL) == static_cast<ssize_t>(packet.size());
+}
+
+auto GDB::client() -> void {
+    auto const post = [this](std::string text) {
+        while (pending.load(std::memory_order_acquire) && running.load(std::memory_order_relaxed)) {
+            std::this_thread::yield();
+        }
+        request = std::move(text);
+        pending.store(true, std::memory_order_release);
+        pending.notify_one();
+    };
+    while (running.load(std::memory_order_relaxed)) {
+        auto listen_poll = pollfd{listen_fd, POLLIN, 0};
+        if (::poll(&listen_poll, 1, 100) <= 0) {
+            continue;
+        }
+        client_fd = ::accept(listen_fd, nullptr, nullptr);
+        if (client_fd < 0) {
+            continue;
+        }
+        // A stop reply meant for a previous connection must not leak into this one
+        replied.store(false, std::memory_order_relaxed);
+        auto buffer = std::string{};
+        auto running_target = false;
+        while (running.load(std::memory_order_relaxed)) {
+            if (replied.load(std::memory_order_acquire)) {
+                replied.store(false, std::memory_order_relaxed);
+                running_target = false;
+                if (!send_packet(reply)) {
+                    break;
+                }
+            }
+            auto client_poll = pollfd{client_fd, POLLIN, 0};
+            if (::poll(&client_poll, 1, 10) <= 0) {
+                continue;
+            }
+            char data[4096];
+            auto const count = ::recv(client_fd, data, sizeof(data), 0);
+            if (count <= 0) {
+                break;
+            }
+            buffer.append(data, static_cast<std::size_t>(count));
+            while (!buffer.empty()) {
+                if (buffer[0] == '\x03') {
+                    buffer.erase(0, 1);
+                    if (running_target) {
+                        post("\x03");
+                    }
+                    continue;
+                }
+                auto const start = buffer.find('$');
+                auto const end = buffer.find('#', start);
+                if (start == buffer.npos || end == buffer.npos || end + 3 > buffer.size()) {
+                    // Drop acks and noise, keep an incomplete packet for the next read
+                    buffer.erase(0, start == buffer.npos ? buffer.size() : start);
+                    break;
+                }
+                auto const packet = buffer.substr(start + 1, end - start - 1);
+                buffer.erase(0, end + 3);
+                ::send(client_fd, "+", 1, MSG_NOSIGNAL);
+                auto const async = !packet.empty() && (packet[0] == 'c' || packet[0] == 's');
+                post(packet);
+                if (async) {
+                    running_target = true;
+                } else if (packet[0] != 'k') {
+                    replied.wait(false, std::memory_order_acquire);
+                    replied.store(false, std::memory_order_relaxed);
+                    if (!send_packet(reply)) {
+                        break;
+                    }
+                }
+            }
+        }
+        // Losing the connection detaches, the game keeps running without points
+        post("\x04");
+        ::close(client_fd);
+        client_fd = -1;
+    }
+}
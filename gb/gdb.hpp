@@ -0,0 +1,93 @@
+#pragma once
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "cpu.hpp"
+#include "debugger.hpp"
+#include "mcb1.hpp"
+
+/// GDB remote serial protocol stub.
+/// Socket I/O runs on its own thread and hands each packet to the emulation thread through a single request slot.
+/// The emulation side runs in short slices and only looks at the pending flag between them, so a connected debugger
+/// that is not asking for anything costs one atomic load per scanline.
+/// Registers are exposed as six little endian 16 bit values: AF, BC, DE, HL, SP, PC.
+struct gb::GDB final {
+    static constexpr std::uint64_t slice_cycles = 456;
+
+    CPU& cpu;
+    CPU::MCB1& mem;
+    /// Shared with whoever set points before, the client's own are tracked in mappings
+    Debugger& debugger;
+    Debugger* previous = {};
+
+    /// Request slot, written by the stub thread and consumed by the emulation thread
+    std::string request = {};
+    std::atomic<bool> pending = {};
+
+    /// Reply slot, written by the emulation thread and sent by the stub thread
+    std::string reply = {};
+    std::atomic<bool> replied = {};
+
+    std::atomic<bool> running = {};
+    std::thread thread = {};
+    int listen_fd = -1;
+    int client_fd = -1;
+
+    /// Emulation thread state
+    bool halted = true;
+    bool stepping = {};
+    bool killed = {};
+
+    /// Last stop reply, repeated for '?'
+    std::string stop_reply = "S05";
+
+    /// Z packet type and range, z has to name the same ones to remove it
+    struct Mapping {
+        char type = {};
+        word_t address = {};
+        unsigned length = {};
+        int id = {};
+    };
+    std::vector<Mapping> mappings = {};
+
+    GDB(CPU& cpu, CPU::MCB1& mem, Debugger& debugger) noexcept
+        : cpu(cpu), mem(mem), debugger(debugger), previous(mem.debugger) {
+        mem.debugger = &debugger;
+    }
+    GDB(GDB const&) = delete;
+    GDB& operator=(GDB const&) = delete;
+    ~GDB();
+
+    /// Listens on a TCP port on localhost, or on a Unix socket when the name contains a '/'
+    auto listen(char const* where) -> bool;
+
+    /// Emulation thread, runs until cycles reaches until while serving the debugger, starts out halted
+    auto run(std::uint64_t until) -> CPU::Status;
+
+    auto stop() noexcept -> void;
+
+    /// Emulation thread side of the request slot
+    auto serve() -> void;
+
+    auto handle(std::string const& packet) -> void;
+
+    /// Removes the points the client set, everything else in debugger stays
+    auto forget() -> void;
+
+    /// Register numbers follow the order of the 'g' packet
+    auto get_register(unsigned index) const noexcept -> word_t;
+
+    auto set_register(unsigned index, word_t value) noexcept -> void;
+
+    /// Reports the watchpoint in debugger.hit as well when watch is set
+    auto stopped(int signal, bool watch = false) -> void;
+
+    auto post_reply(std::string text) -> void;
+
+    /// Stub thread
+    auto client() -> void;
+
+    auto send_packet(std::string const& text) -> bool;
+};
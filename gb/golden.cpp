@@ -0,0 +1,184 @@
+#include "golden.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+#include "kernels.hpp"
+#include "machine.hpp"
+#include "metrics.hpp"
+#include "png.hpp"
+
+using namespace gb;
+
+auto Golden::hash(PPU::Frame const& frame) noexcept -> std::uint64_t {
+    return Kernels::best().hash(reinterpret_cast<byte_t const*>(frame.data()), sizeof(frame), 0);
+}
+
+auto Golden::perceptual(PPU::Frame const& frame) noexcept -> std::uint64_t {
+    constexpr std::size_t columns = 9, rows = 8;
+    std::uint32_t cells[rows][columns] = {};
+    for (auto row = std::size_t{}; row != rows; ++row) {
+        auto const y0 = row * PPU::height / rows, y1 = (row + 1) * PPU::height / rows;
+        for (auto column = std::size_t{}; column != columns; ++column) {
+            auto const x0 = column * PPU::width / columns, x1 = (column + 1) * PPU::width / columns;
+            auto sum = std::uint32_t{};
+            for (auto y = y0; y != y1; ++y) {
+                for (auto x = x0; x != x1; ++x) {
+                    auto const pixel = frame[y * PPU::width + x];
+                    sum += ((pixel >> 16 & 0xFF) * 77 + (pixel >> 8 & 0xFF) * 150 + (pixel & 0xFF) * 29) >> 8;
+                }
+            }
+            cells[row][column] = static_cast<std::uint32_t>(sum / ((y1 - y0) * (x1 - x0)));
+        }
+    }
+    auto result = std::uint64_t{};
+    for (auto row = std::size_t{}; row != rows; ++row) {
+        for (auto column = std::size_t{}; column != columns - 1; ++column) {
+            result = result << 1 | (cells[row][column] > cells[row][column + 1]);
+        }
+    }
+    return result;
+}
+
+auto Golden::distance(std::uint64_t a, std::uint64_t b) noexcept -> int { return std::popcount(a ^ b); }
+
+auto Golden::capture(byte_t const* rom, std::size_t size, std::vector<std::uint64_t> const& frames,
+                     std::string const& png_prefix, PPU::Renderer renderer, Metrics* metrics) -> std::vector<Shot> {
+    auto shots = std::vector<Shot>{};
+    auto const machine = std::make_unique<Machine>();
+    machine->mem.ppu.renderer = renderer;
+    if (!machine->load(rom, size)) {
+        return shots;
+    }
+    auto status = CPU::Status::OK;
+    auto rgba = std::vector<byte_t>{};
+    auto const& pixels = machine->mem.ppu.framebuffer;
+    for (auto const frame : frames) {
+        auto const until = frame * frame_cycles;
+        if (status == CPU::Status::OK && machine->mem.cycles < until) {
+            status = machine->run(until - machine->mem.cycles);
+        }
+        shots.push_back({frame, hash(pixels), perceptual(pixels)});
+        if (!png_prefix.empty()) {
+            rgba.resize(pixels.size() * 4);
+            Kernels::best().to_rgba(pixels.data(), pixels.size(), rgba.data());
+            PNG::write((png_prefix + std::to_string(frame) + ".png").c_str(), rgba.data(), PPU::width, PPU::height);
+        }
+    }
+    if (metrics) {
+        *metrics += Metrics::snapshot(machine->mem);
+    }
+    return shots;
+}
+
+auto Golden::load(std::filesystem::path const& manifest) -> bool {
+    auto file = std::ifstream(manifest);
+    if (!file) {
+        return false;
+    }
+    entries.clear();
+    for (auto line = std::string{}; std::getline(file, line);) {
+        if (auto const comment = line.find('#'); comment != std::string::npos) {
+            line.resize(comment);
+        }
+        auto fields = std::istringstream(line);
+        auto entry = Entry{};
+        auto hash = std::string{}, perceptual = std::string{};
+        if (!(fields >> entry.rom)) {
+            continue;
+        }
+        if (!(fields >> entry.expected.frame >> hash >> perceptual)) {
+            return false;
+        }
+        entry.known = hash != "-";
+        if (entry.known) {
+            try {
+                entry.expected.hash = std::stoull(hash, nullptr, 16);
+                entry.expected.perceptual = std::stoull(perceptual, nullptr, 16);
+            } catch (std::exception const&) {
+                return false;
+            }
+        }
+        entries.push_back(std::move(entry));
+    }
+    return true;
+}
+
+auto Golden::save(std::filesystem::path const& manifest) const -> bool {
+    auto file = std::ofstream(manifest);
+    file << "# rom frame hash perceptual\n";
+    for (auto const& entry : entries) {
+        char hashes[40] = "- -";
+        if (entry.known) {
+            snprintf(hashes, sizeof(hashes), "%016llx %016llx", static_cast<unsigned long long>(entry.expected.hash),
+                     static_cast<unsigned long long>(entry.expected.perceptual));
+        }
+        file << entry.rom << ' ' << entry.expected.frame << ' ' << hashes << '\n';
+    }
+    return static_cast<bool>(file.flush());
+}
+
+auto Golden::run(std::filesystem::path const& base, unsigned jobs, std::filesystem::path const& png_dir,
+                 std::vector<std::string>& failed, Metrics* metrics) const -> std::vector<Shot> {
+    // Entries of each ROM in frame order, so every ROM runs once
+    auto groups = std::map<std::string, std::vector<std::size_t>>{};
+    for (auto i = std::size_t{}; i != entries.size(); ++i) {
+        groups[entries[i].rom].push_back(i);
+    }
+    auto work = std::vector<std::pair<std::string const*, std::vector<std::size_t>*>>{};
+    for (auto& [rom, indices] : groups) {
+        std::stable_sort(indices.begin(), indices.end(),
+                         [&](auto a, auto b) { return entries[a].expected.frame < entries[b].expected.frame; });
+        work.emplace_back(&rom, &indices);
+    }
+
+    auto shots = std::vector<Shot>(entries.size());
+    auto next = std::atomic<std::size_t>{};
+    auto mutex = std::mutex{};
+    auto const worker = [&] {
+        auto counted = Metrics{};
+        for (auto index = next++; index < work.size(); index = next++) {
+            auto const& [rom, indices] = work[index];
+            auto file = std::ifstream(base / *rom, std::ios::binary);
+            auto const data = std::vector<byte_t>(std::istreambuf_iterator<char>(file), {});
+            auto frames = std::vector<std::uint64_t>{};
+            for (auto const i : *indices) {
+                frames.push_back(entries[i].expected.frame);
+            }
+            auto const prefix =
+                png_dir.empty() ? std::string{} : (png_dir / std::filesystem::path(*rom).stem()).string() + "_";
+            auto const taken =
+                capture(data.data(), data.size(), frames, prefix, compat.renderer(data.data(), data.size()), &counted);
+            if (taken.size() != frames.size()) {
+                auto const lock = std::lock_guard(mutex);
+                failed.push_back(*rom);
+                continue;
+            }
+            for (auto i = std::size_t{}; i != taken.size(); ++i) {
+                shots[(*indices)[i]] = taken[i];
+            }
+        }
+        if (metrics) {
+            auto const lock = std::lock_guard(mutex);
+            *metrics += counted;
+        }
+    };
+    auto threads = std::vector<std::thread>{};
+    for (auto i = 1u; i < std::min<std::size_t>(jobs, work.size()); ++i) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    return shots;
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "compat.hpp"
+#include "ppu.hpp"
+
+/// Golden frame regression checks.
+/// A manifest lists one ROM, frame number, exact hash and perceptual hash per line. Every ROM runs headless on its
+/// own Machine, as fast as the host allows and spread over worker threads, and the screen after the listed number of
+/// frames is hashed. The exact hash is what gates a change, the perceptual one tells a shifted pixel from a
+/// completely different picture when they disagree.
+struct gb::Golden final {
+    struct Shot {
+        std::uint64_t frame = {};
+        std::uint64_t hash = {};
+        std::uint64_t perceptual = {};
+    };
+
+    struct Entry {
+        std::string rom = {};
+        Shot expected = {};
+        /// False until the first update, written as - in the manifest
+        bool known = {};
+    };
+
+    std::vector<Entry> entries = {};
+
+    /// Renderer every ROM of run() gets
+    Compat compat = {};
+
+    /// Kernels hash of the pixels
+    static auto hash(PPU::Frame const& frame) noexcept -> std::uint64_t;
+
+    /// Difference hash, one bit per neighbouring pair of cells in a 9 x 8 grid of average brightness
+    static auto perceptual(PPU::Frame const& frame) noexcept -> std::uint64_t;
+
+    /// Differing bits of two perceptual hashes, 0 - 64
+    static auto distance(std::uint64_t a, std::uint64_t b) noexcept -> int;
+
+    /// Runs rom and takes a shot after each of the ascending frame counts. A run that stops on HALT, STOP or a bad
+    /// opcode keeps its last picture for the remaining shots. With png_prefix set, every shot is also written to
+    /// <png_prefix><frame>.png. The machine's counters are added to metrics when it is set.
+    static auto capture(byte_t const* rom, std::size_t size, std::vector<std::uint64_t> const& frames,
+                        std::string const& png_prefix = {}, PPU::Renderer renderer = PPU::Renderer::SCANLINE,
+                        Metrics* metrics = {}) -> std::vector<Shot>;
+
+    /// Lines of "rom frame hash perceptual", paths relative to the manifest, # starts a comment
+    auto load(std::filesystem::path const& manifest) -> bool;
+
+    auto save(std::filesystem::path const& manifest) const -> bool;
+
+    /// Captures every entry, ROM paths resolved against base, one shot per entry in the same order. ROMs that fail to
+    /// load are reported through failed and get empty shots. Each worker sums the counters of its machines, and metrics
+    /// gets the total of all workers when it is set.
+    auto run(std::filesystem::path const& base, unsigned jobs, std::filesystem::path const& png_dir,
+             std::vector<std::string>& failed, Metrics* metrics = {}) const -> std::vector<Shot>;
+};
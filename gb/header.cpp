@@ -0,0 +1,111 @@
+#include "header.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+#include "boot.hpp"
+
+using namespace gb;
+
+namespace {
+    struct Type {
+        byte_t code;
+        Header::Mapper mapper;
+        bool battery;
+        bool timer;
+        bool rumble;
+    };
+
+    using enum Header::Mapper;
+
+    /// Cartridge types of 0x147, RAM is told by 0x149 alone
+    constexpr Type types[] = {
+        {0x00, NONE, false, false, false},  {0x01, MBC1, false, false, false},   {0x02, MBC1, false, false, false},
+        {0x03, MBC1, true, false, false},   {0x05, MBC2, false, false, false},   {0x06, MBC2, true, false, false},
+        {0x08, NONE, false, false, false},  {0x09, NONE, true, false, false},    {0x0B, MMM01, false, false, false},
+        {0x0C, MMM01, false, false, false}, {0x0D, MMM01, true, false, false},   {0x0F, MBC3, true, true, false},
+        {0x10, MBC3, true, true, false},    {0x11, MBC3, false, false, false},   {0x12, MBC3, false, false, false},
+        {0x13, MBC3, true, false, false},   {0x19, MBC5, false, false, false},   {0x1A, MBC5, false, false, false},
+        {0x1B, MBC5, true, false, false},   {0x1C, MBC5, false, false, true},    {0x1D, MBC5, false, false, true},
+        {0x1E, MBC5, true, false, true},    {0x20, MBC6, false, false, false},   {0x22, MBC7, true, false, true},
+        {0xFC, CAMERA, false, false, false}, {0xFD, TAMA5, false, false, false}, {0xFE, HUC3, false, false, false},
+        {0xFF, HUC1, true, false, false},
+    };
+
+    constexpr std::size_t ram_sizes[] = {0, 0, 0x2000, 0x8000, 0x20000, 0x10000};
+}
+
+auto Header::parse(byte_t const* rom, std::size_t size) noexcept -> Header {
+    auto header = Header{};
+    if (size < end) {
+        return header;
+    }
+    header.present = true;
+    // Title shrank over the years as the CGB flag and manufacturer code took its last bytes
+    auto const title_end = (rom[0x143] & 0x80) ? 0x143 : 0x144;
+    for (auto address = 0x134; address != title_end && rom[address] >= 0x20 && rom[address] <= 0x7E; ++address) {
+        header.title += static_cast<char>(rom[address]);
+    }
+    header.type = rom[0x147];
+    auto const type = std::find_if(std::begin(types), std::end(types), [&](auto& t) { return t.code == header.type; });
+    if (type != std::end(types)) {
+        header.mapper = type->mapper;
+        header.battery = type->battery;
+        header.timer = type->timer;
+        header.rumble = type->rumble;
+    }
+    header.rom_size = rom[0x148] <= 0x08 ? std::size_t{0x8000} << rom[0x148] : 0;
+    header.ram_size = rom[0x149] < std::size(ram_sizes) ? ram_sizes[rom[0x149]] : 0;
+    header.cgb = (rom[0x143] & 0x80) != 0;
+    header.cgb_only = (rom[0x143] & 0xC0) == 0xC0;
+    header.sgb = rom[0x146] == 0x03;
+    header.logo = std::equal(Boot::logo.begin(), Boot::logo.end(), rom + 0x104);
+
+    header.header_checksum = rom[0x14D];
+    for (auto address = 0x134; address != 0x14D; ++address) {
+        header.header_expected = static_cast<byte_t>(header.header_expected - rom[address] - 1);
+    }
+    // Stored big endian, unlike everything else in the header
+    header.global_checksum = word_pack(rom[0x14F], rom[0x14E]);
+    auto sum = 0u;
+    for (auto i = std::size_t{}; i != size; ++i) {
+        sum += rom[i];
+    }
+    header.global_expected = static_cast<word_t>(sum - rom[0x14E] - rom[0x14F]);
+    return header;
+}
+
+auto Header::name(Mapper mapper) noexcept -> char const* {
+    constexpr char const* names[] = {"ROM only", "MBC1", "MBC2",   "MMM01", "MBC3", "MBC5",   "MBC6",
+                                     "MBC7",     "camera", "TAMA5", "HuC3", "HuC1", "unknown"};
+    return names[static_cast<std::size_t>(mapper)];
+}
+
+auto Header::problems(std::size_t size) const -> std::vector<std::string> {
+    auto result = std::vector<std::string>{};
+    if (!present) {
+        result.emplace_back("image too short for a cartridge header");
+        return result;
+    }
+    char line[96];
+    if (!logo) {
+        result.emplace_back("logo does not match, a boot ROM would lock up");
+    }
+    if (header_checksum != header_expected) {
+        snprintf(line, sizeof(line), "header checksum %02X, expected %02X", header_checksum, header_expected);
+        result.emplace_back(line);
+    }
+    if (global_checksum != global_expected) {
+        snprintf(line, sizeof(line), "global checksum %04X, expected %04X", global_checksum, global_expected);
+        result.emplace_back(line);
+    }
+    if (!supported()) {
+        snprintf(line, sizeof(line), "cartridge type %02X (%s) is not supported, banking as MBC1", type, name(mapper));
+        result.emplace_back(line);
+    }
+    if (rom_size != size) {
+        snprintf(line, sizeof(line), "header declares %zu bytes of ROM, image has %zu", rom_size, size);
+        result.emplace_back(line);
+    }
+    return result;
+}
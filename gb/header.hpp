@@ -0,0 +1,50 @@
+#pragma once
+#include <string>
+#include <vector>
+
+#include "common.hpp"
+
+/// Cartridge header at 0x100 - 0x14F.
+/// parse() decodes what the hardware and the boot ROM look at and checks both checksums against the image, the
+/// emulator itself only implements MBC1 banking, which plain ROM carts run on as well.
+struct gb::Header final {
+    /// First byte past the header, parse() reads further only for the global checksum
+    static constexpr std::size_t end = 0x150;
+
+    enum class Mapper : byte_t { NONE, MBC1, MBC2, MMM01, MBC3, MBC5, MBC6, MBC7, CAMERA, TAMA5, HUC3, HUC1, UNKNOWN };
+
+    /// False for images too short to hold a header, everything else is left empty then
+    bool present = {};
+    std::string title = {};
+    byte_t type = {};
+    Mapper mapper = Mapper::UNKNOWN;
+    bool battery = {};
+    bool timer = {};
+    bool rumble = {};
+
+    /// Sizes the header declares, 0 for codes it does not define
+    std::size_t rom_size = {};
+    std::size_t ram_size = {};
+
+    /// 0x143 bit 7, CGB only with bit 6 as well
+    bool cgb = {};
+    bool cgb_only = {};
+    bool sgb = {};
+
+    /// Logo the boot ROM compares against, and both checksums as stored and as computed
+    bool logo = {};
+    byte_t header_checksum = {};
+    byte_t header_expected = {};
+    word_t global_checksum = {};
+    word_t global_expected = {};
+
+    static auto parse(byte_t const* rom, std::size_t size) noexcept -> Header;
+
+    static auto name(Mapper mapper) noexcept -> char const*;
+
+    /// Runs on MCB1 as it is
+    auto supported() const noexcept -> bool { return mapper == Mapper::NONE || mapper == Mapper::MBC1; }
+
+    /// One line per problem worth a warning for an image of size bytes, empty for a well formed cartridge
+    auto problems(std::size_t size) const -> std::vector<std::string>;
+};
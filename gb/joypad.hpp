@@ -0,0 +1,66 @@
+#pragma once
+#include "common.hpp"
+#include "spsc.hpp"
+
+/// Joypad register (0xFF00) fed by timestamped button states from a host thread.
+/// The emulation side latches how many events are visible only at batch boundaries and applies each one at the
+/// first instruction boundary at or after its cycle, so results do not depend on when the host thread got to run.
+struct gb::Joypad final {
+    enum class Button : byte_t {
+        RIGHT = 0x01,
+        LEFT = 0x02,
+        UP = 0x04,
+        DOWN = 0x08,
+        A = 0x10,
+        B = 0x20,
+        SELECT = 0x40,
+        START = 0x80,
+    };
+
+    struct Event {
+        std::uint64_t cycle = {};
+        byte_t buttons = {};
+    };
+
+    static constexpr std::uint64_t never = ~std::uint64_t{};
+
+    SPSC<Event, 256> queue = {};
+    std::size_t latched = {};
+    byte_t buttons = {};
+    byte_t select = 0x30;
+
+    /// Producer side, buttons is the full pressed state as Button bits
+    auto push(std::uint64_t cycle, byte_t state) noexcept -> bool { return queue.push(Event{cycle, state}); }
+
+    /// Consumer side, makes events pushed so far visible to the current batch
+    auto latch() noexcept -> void { latched = queue.size(); }
+
+    auto next_cycle() const noexcept -> std::uint64_t { return latched ? queue.front().cycle : never; }
+
+    /// Applies every latched event that is due, returns cycle of the next one
+    auto apply(std::uint64_t cycles) noexcept -> std::uint64_t {
+        while (latched && queue.front().cycle <= cycles) {
+            buttons = queue.front().buttons;
+            queue.pop();
+            --latched;
+        }
+        return next_cycle();
+    }
+
+    gb_func read() const noexcept->byte_t {
+        auto pressed = 0;
+        if (!(select & 0x10)) {
+            pressed |= buttons & 0x0F;
+        }
+        if (!(select & 0x20)) {
+            pressed |= buttons >> 4;
+        }
+        return static_cast<byte_t>(0xC0 | select | (~pressed & 0x0F));
+    }
+
+    gb_func write(byte_t value) noexcept->void { select = value & 0x30; }
+};
+
+namespace gb {
+    gb_flag_ops(Joypad::Button);
+}
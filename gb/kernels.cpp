@@ -0,0 +1,128 @@
+#include "kernels.hpp"
+
+#include <cstdlib>
+#include <cstring>
+
+using namespace gb;
+
+namespace {
+    namespace reference {
+        auto hash(byte_t const* data, std::size_t size, std::uint64_t seed) noexcept -> std::uint64_t {
+            std::uint64_t acc[8];
+            for (auto i = 0; i != 8; ++i) {
+                acc[i] = Kernels::keys[i] ^ seed;
+            }
+            auto const stripes = size / Kernels::stripe_size;
+            for (auto s = std::size_t{}; s != stripes; ++s) {
+                Kernels::hash_stripe(acc, data + s * Kernels::stripe_size);
+                if ((s + 1) % Kernels::stripes_per_block == 0) {
+                    Kernels::hash_scramble(acc);
+                }
+            }
+            return Kernels::hash_finish(acc, data + stripes * Kernels::stripe_size, size % Kernels::stripe_size, size,
+                                        seed);
+        }
+
+        auto xor_delta(byte_t* out, byte_t const* a, byte_t const* b, std::size_t size) noexcept -> bool {
+            auto any = byte_t{};
+            for (auto i = std::size_t{}; i != size; ++i) {
+                out[i] = a[i] ^ b[i];
+                any |= out[i];
+            }
+            return any != 0;
+        }
+
+        auto to_rgba(std::uint32_t const* in, std::size_t count, byte_t* out) noexcept -> void {
+            for (auto i = std::size_t{}; i != count; ++i) {
+                out[i * 4 + 0] = static_cast<byte_t>(in[i] >> 16);
+                out[i * 4 + 1] = static_cast<byte_t>(in[i] >> 8);
+                out[i * 4 + 2] = static_cast<byte_t>(in[i]);
+                out[i * 4 + 3] = static_cast<byte_t>(in[i] >> 24);
+            }
+        }
+    }
+
+    auto supported(Kernels::ISA isa) noexcept -> bool {
+        switch (isa) {
+            case Kernels::ISA::SCALAR:
+                return true;
+#if defined(__x86_64__) || defined(__i386__)
+            case Kernels::ISA::SSE2:
+                return __builtin_cpu_supports("sse2");
+            case Kernels::ISA::AVX2:
+                return __builtin_cpu_supports("avx2");
+            case Kernels::ISA::AVX512:
+                return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+#endif
+            default:
+                return false;
+        }
+    }
+
+    auto select() noexcept -> Kernels const& {
+        constexpr char const* names[] = {"scalar", "sse2", "avx2", "avx512"};
+        auto limit = static_cast<int>(Kernels::ISA::AVX512);
+        if (auto const env = std::getenv("GB_ISA")) {
+            for (auto isa = 0; isa != static_cast<int>(std::size(names)); ++isa) {
+                if (!std::strcmp(env, names[isa])) {
+                    limit = isa;
+                }
+            }
+        }
+        for (auto isa = limit; isa >= 0; --isa) {
+            if (auto const kernels = Kernels::get(static_cast<Kernels::ISA>(isa))) {
+                return *kernels;
+            }
+        }
+        return Kernels::scalar;
+    }
+}
+
+constinit Kernels const Kernels::scalar = {
+    ISA::SCALAR, "scalar", reference::hash, reference::xor_delta, reference::to_rgba,
+};
+
+auto Kernels::get(ISA isa) noexcept -> Kernels const* {
+    if (!supported(isa)) {
+        return nullptr;
+    }
+    switch (isa) {
+        case ISA::SCALAR:
+            return &scalar;
+#if defined(__x86_64__) || defined(__i386__)
+        case ISA::SSE2:
+            return &sse2;
+        case ISA::AVX2:
+            return &avx2;
+        case ISA::AVX512:
+            return &avx512;
+#endif
+        default:
+            return nullptr;
+    }
+}
+
+auto Kernels::best() noexcept -> Kernels const& {
+    static Kernels const& kernels = select();
+    return kernels;
+}
+
+auto Kernels::hash_finish(std::uint64_t (&acc)[8], byte_t const* tail, std::size_t tail_size, std::size_t size,
+                          std::uint64_t seed) noexcept -> std::uint64_t {
+    if (tail_size) {
+        byte_t last[stripe_size] = {};
+        std::memcpy(last, tail, tail_size);
+        hash_stripe(acc, last);
+    }
+    auto h = static_cast<std::uint64_t>(size) * prime64_1 ^ seed;
+    for (auto const value : acc) {
+        h ^= value * prime64_2;
+        h = std::rotl(h, 31) * prime64_1;
+    }
+    h ^= h >> 33;
+    h *= prime64_2;
+    h ^= h >> 29;
+    h *= prime64_1;
+    h ^= h >> 32;
+    return h;
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include "common.hpp"
+
+/// Bulk kernels over emulator memory with one implementation per instruction set.
+/// Every variant computes exactly what the scalar reference does, the one to use is picked once from CPUID so a
+/// single binary runs everywhere and still uses the widest vectors the host has. GB_ISA=scalar|sse2|avx2|avx512 in
+/// the environment caps the choice.
+struct gb::Kernels final {
+    enum class ISA : byte_t { SCALAR, SSE2, AVX2, AVX512 };
+
+    /// Hash block size, every variant scrambles its accumulators after the same number of bytes
+    static constexpr std::size_t stripe_size = 64;
+    static constexpr std::size_t stripes_per_block = 16;
+
+    ISA isa = {};
+    char const* name = {};
+
+    /// 64 bit hash of size bytes, the same value on every variant
+    std::uint64_t (*hash)(byte_t const* data, std::size_t size, std::uint64_t seed) noexcept = {};
+
+    /// out = a ^ b, returns false if all of out is zero
+    bool (*xor_delta)(byte_t* out, byte_t const* a, byte_t const* b, std::size_t size) noexcept = {};
+
+    /// PPU::Frame pixels (0xAARRGGBB) to R, G, B, A bytes
+    void (*to_rgba)(std::uint32_t const* in, std::size_t count, byte_t* out) noexcept = {};
+
+    /// Variant for isa, nullptr if it was not built or the host does not support it
+    static auto get(ISA isa) noexcept -> Kernels const*;
+
+    /// Widest supported variant, chosen on first use
+    static auto best() noexcept -> Kernels const&;
+
+    /// Variant tables, each defined next to its code
+    static Kernels const scalar;
+#if defined(__x86_64__) || defined(__i386__)
+    static Kernels const sse2;
+    static Kernels const avx2;
+    static Kernels const avx512;
+#endif
+
+    /// Tail and final mix, shared by every variant so they stay identical
+    static auto hash_finish(std::uint64_t (&acc)[8], byte_t const* tail, std::size_t tail_size, std::size_t size,
+                            std::uint64_t seed) noexcept -> std::uint64_t;
+
+    static constexpr std::uint64_t prime32 = 0x9E3779B1;
+    static constexpr std::uint64_t prime64_1 = 0x9E3779B185EBCA87;
+    static constexpr std::uint64_t prime64_2 = 0xC2B2AE3D27D4EB4F;
+    static constexpr std::uint64_t keys[8] = {
+        0xBE4BA423396CFEB8, 0x1CAD21F72C81017C, 0xDB979083E96DD4DE, 0x1F67B3B7A4A44072,
+        0x78E5C0CC4EE679CB, 0x2172FFCC7DD05A82, 0x8E2443F7744608B8, 0x4C263A81E69035E0,
+    };
+
+    /// Scalar building blocks, the vector variants do the same per 64 bit lane
+    gb_func static hash_stripe(std::uint64_t (&acc)[8], byte_t const* data) noexcept->void {
+        for (auto i = 0; i != 8; ++i) {
+            auto x = std::uint64_t{};
+            for (auto b = 0; b != 8; ++b) {
+                x |= static_cast<std::uint64_t>(data[i * 8 + b]) << (b * 8);
+            }
+            auto const key = x ^ keys[i];
+            acc[i ^ 1] += x;
+            acc[i] += (key & 0xFFFFFFFF) * (key >> 32);
+        }
+    }
+
+    gb_func static hash_scramble(std::uint64_t (&acc)[8]) noexcept->void {
+        for (auto i = 0; i != 8; ++i) {
+            acc[i] = (acc[i] ^ (acc[i] >> 47) ^ keys[i]) * prime32;
+        }
+    }
+};
@@ -0,0 +1,207 @@
+#include "kernels.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+
+using namespace gb;
+
+// Each variant is compiled for its own instruction set through target attributes, the rest of the build stays on the
+// baseline ISA and only reaches these through the table Kernels::best() picked
+
+#define GB_SSE2 __attribute__((target("sse2")))
+#define GB_AVX2 __attribute__((target("avx2")))
+#define GB_AVX512 __attribute__((target("avx512f,avx512bw")))
+
+namespace {
+    namespace sse2 {
+        GB_SSE2 auto hash(byte_t const* data, std::size_t size, std::uint64_t seed) noexcept -> std::uint64_t {
+            __m128i acc[4];
+            __m128i key[4];
+            for (auto i = 0; i != 4; ++i) {
+                key[i] = _mm_set_epi64x(static_cast<long long>(Kernels::keys[i * 2 + 1]),
+                                        static_cast<long long>(Kernels::keys[i * 2]));
+                acc[i] = _mm_xor_si128(key[i], _mm_set1_epi64x(static_cast<long long>(seed)));
+            }
+            auto const prime = _mm_set1_epi64x(Kernels::prime32);
+            auto const stripes = size / Kernels::stripe_size;
+            for (auto s = std::size_t{}; s != stripes; ++s) {
+                auto const stripe = reinterpret_cast<__m128i const*>(data + s * Kernels::stripe_size);
+                for (auto i = 0; i != 4; ++i) {
+                    auto const x = _mm_loadu_si128(stripe + i);
+                    auto const k = _mm_xor_si128(x, key[i]);
+                    auto const product = _mm_mul_epu32(k, _mm_srli_epi64(k, 32));
+                    acc[i] = _mm_add_epi64(acc[i], _mm_add_epi64(product, _mm_shuffle_epi32(x, 0x4E)));
+                }
+                if ((s + 1) % Kernels::stripes_per_block == 0) {
+                    for (auto i = 0; i != 4; ++i) {
+                        auto const a = _mm_xor_si128(_mm_xor_si128(acc[i], _mm_srli_epi64(acc[i], 47)), key[i]);
+                        auto const lo = _mm_mul_epu32(a, prime);
+                        auto const hi = _mm_mul_epu32(_mm_srli_epi64(a, 32), prime);
+                        acc[i] = _mm_add_epi64(lo, _mm_slli_epi64(hi, 32));
+                    }
+                }
+            }
+            std::uint64_t result[8];
+            for (auto i = 0; i != 4; ++i) {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(result + i * 2), acc[i]);
+            }
+            return Kernels::hash_finish(result, data + stripes * Kernels::stripe_size, size % Kernels::stripe_size,
+                                        size, seed);
+        }
+
+        GB_SSE2 auto xor_delta(byte_t* out, byte_t const* a, byte_t const* b, std::size_t size) noexcept -> bool {
+            auto any = _mm_setzero_si128();
+            auto i = std::size_t{};
+            for (; i + 16 <= size; i += 16) {
+                auto const value = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<__m128i const*>(a + i)),
+                                                 _mm_loadu_si128(reinterpret_cast<__m128i const*>(b + i)));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), value);
+                any = _mm_or_si128(any, value);
+            }
+            auto const tail = Kernels::scalar.xor_delta(out + i, a + i, b + i, size - i);
+            return tail || _mm_movemask_epi8(_mm_cmpeq_epi8(any, _mm_setzero_si128())) != 0xFFFF;
+        }
+
+        GB_SSE2 auto to_rgba(std::uint32_t const* in, std::size_t count, byte_t* out) noexcept -> void {
+            auto const keep = _mm_set1_epi32(static_cast<int>(0xFF00FF00));
+            auto const low = _mm_set1_epi32(0xFF);
+            auto i = std::size_t{};
+            for (; i + 4 <= count; i += 4) {
+                auto const x = _mm_loadu_si128(reinterpret_cast<__m128i const*>(in + i));
+                auto const red = _mm_and_si128(_mm_srli_epi32(x, 16), low);
+                auto const blue = _mm_slli_epi32(_mm_and_si128(x, low), 16);
+                auto const value = _mm_or_si128(_mm_and_si128(x, keep), _mm_or_si128(red, blue));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i * 4), value);
+            }
+            Kernels::scalar.to_rgba(in + i, count - i, out + i * 4);
+        }
+    }
+
+    namespace avx2 {
+        GB_AVX2 auto hash(byte_t const* data, std::size_t size, std::uint64_t seed) noexcept -> std::uint64_t {
+            __m256i acc[2];
+            __m256i key[2];
+            for (auto i = 0; i != 2; ++i) {
+                key[i] = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(Kernels::keys + i * 4));
+                acc[i] = _mm256_xor_si256(key[i], _mm256_set1_epi64x(static_cast<long long>(seed)));
+            }
+            auto const prime = _mm256_set1_epi64x(Kernels::prime32);
+            auto const stripes = size / Kernels::stripe_size;
+            for (auto s = std::size_t{}; s != stripes; ++s) {
+                auto const stripe = reinterpret_cast<__m256i const*>(data + s * Kernels::stripe_size);
+                for (auto i = 0; i != 2; ++i) {
+                    auto const x = _mm256_loadu_si256(stripe + i);
+                    auto const k = _mm256_xor_si256(x, key[i]);
+                    auto const product = _mm256_mul_epu32(k, _mm256_srli_epi64(k, 32));
+                    acc[i] = _mm256_add_epi64(acc[i], _mm256_add_epi64(product, _mm256_shuffle_epi32(x, 0x4E)));
+                }
+                if ((s + 1) % Kernels::stripes_per_block == 0) {
+                    for (auto i = 0; i != 2; ++i) {
+                        auto const a =
+                            _mm256_xor_si256(_mm256_xor_si256(acc[i], _mm256_srli_epi64(acc[i], 47)), key[i]);
+                        auto const lo = _mm256_mul_epu32(a, prime);
+                        auto const hi = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), prime);
+                        acc[i] = _mm256_add_epi64(lo, _mm256_slli_epi64(hi, 32));
+                    }
+                }
+            }
+            std::uint64_t result[8];
+            for (auto i = 0; i != 2; ++i) {
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(result + i * 4), acc[i]);
+            }
+            return Kernels::hash_finish(result, data + stripes * Kernels::stripe_size, size % Kernels::stripe_size,
+                                        size, seed);
+        }
+
+        GB_AVX2 auto xor_delta(byte_t* out, byte_t const* a, byte_t const* b, std::size_t size) noexcept -> bool {
+            auto any = _mm256_setzero_si256();
+            auto i = std::size_t{};
+            for (; i + 32 <= size; i += 32) {
+                auto const value = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<__m256i const*>(a + i)),
+                                                    _mm256_loadu_si256(reinterpret_cast<__m256i const*>(b + i)));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), value);
+                any = _mm256_or_si256(any, value);
+            }
+            auto const tail = sse2::xor_delta(out + i, a + i, b + i, size - i);
+            return tail || !_mm256_testz_si256(any, any);
+        }
+
+        GB_AVX2 auto to_rgba(std::uint32_t const* in, std::size_t count, byte_t* out) noexcept -> void {
+            auto const keep = _mm256_set1_epi32(static_cast<int>(0xFF00FF00));
+            auto const low = _mm256_set1_epi32(0xFF);
+            auto i = std::size_t{};
+            for (; i + 8 <= count; i += 8) {
+                auto const x = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(in + i));
+                auto const red = _mm256_and_si256(_mm256_srli_epi32(x, 16), low);
+                auto const blue = _mm256_slli_epi32(_mm256_and_si256(x, low), 16);
+                auto const value = _mm256_or_si256(_mm256_and_si256(x, keep), _mm256_or_si256(red, blue));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i * 4), value);
+            }
+            sse2::to_rgba(in + i, count - i, out + i * 4);
+        }
+    }
+
+    namespace avx512 {
+        GB_AVX512 auto hash(byte_t const* data, std::size_t size, std::uint64_t seed) noexcept -> std::uint64_t {
+            auto const key = _mm512_loadu_si512(Kernels::keys);
+            auto acc = _mm512_xor_si512(key, _mm512_set1_epi64(static_cast<long long>(seed)));
+            auto const prime = _mm512_set1_epi64(Kernels::prime32);
+            auto const stripes = size / Kernels::stripe_size;
+            for (auto s = std::size_t{}; s != stripes; ++s) {
+                auto const x = _mm512_loadu_si512(data + s * Kernels::stripe_size);
+                auto const k = _mm512_xor_si512(x, key);
+                auto const product = _mm512_mul_epu32(k, _mm512_srli_epi64(k, 32));
+                acc = _mm512_add_epi64(acc, _mm512_add_epi64(product, _mm512_shuffle_epi32(x, _MM_PERM_BADC)));
+                if ((s + 1) % Kernels::stripes_per_block == 0) {
+                    auto const a = _mm512_xor_si512(_mm512_xor_si512(acc, _mm512_srli_epi64(acc, 47)), key);
+                    auto const lo = _mm512_mul_epu32(a, prime);
+                    auto const hi = _mm512_mul_epu32(_mm512_srli_epi64(a, 32), prime);
+                    acc = _mm512_add_epi64(lo, _mm512_slli_epi64(hi, 32));
+                }
+            }
+            std::uint64_t result[8];
+            _mm512_storeu_si512(result, acc);
+            return Kernels::hash_finish(result, data + stripes * Kernels::stripe_size, size % Kernels::stripe_size,
+                                        size, seed);
+        }
+
+        GB_AVX512 auto xor_delta(byte_t* out, byte_t const* a, byte_t const* b, std::size_t size) noexcept -> bool {
+            auto any = _mm512_setzero_si512();
+            auto i = std::size_t{};
+            for (; i + 64 <= size; i += 64) {
+                auto const value = _mm512_xor_si512(_mm512_loadu_si512(a + i), _mm512_loadu_si512(b + i));
+                _mm512_storeu_si512(out + i, value);
+                any = _mm512_or_si512(any, value);
+            }
+            auto const tail = avx2::xor_delta(out + i, a + i, b + i, size - i);
+            return tail || _mm512_test_epi64_mask(any, any) != 0;
+        }
+
+        GB_AVX512 auto to_rgba(std::uint32_t const* in, std::size_t count, byte_t* out) noexcept -> void {
+            auto const keep = _mm512_set1_epi32(static_cast<int>(0xFF00FF00));
+            auto const low = _mm512_set1_epi32(0xFF);
+            auto i = std::size_t{};
+            for (; i + 16 <= count; i += 16) {
+                auto const x = _mm512_loadu_si512(in + i);
+                auto const red = _mm512_and_si512(_mm512_srli_epi32(x, 16), low);
+                auto const blue = _mm512_slli_epi32(_mm512_and_si512(x, low), 16);
+                _mm512_storeu_si512(out + i * 4, _mm512_ternarylogic_epi32(x, keep, _mm512_or_si512(red, blue), 0xEA));
+            }
+            avx2::to_rgba(in + i, count - i, out + i * 4);
+        }
+    }
+}
+
+constinit Kernels const Kernels::sse2 = {
+    ISA::SSE2, "sse2", sse2::hash, sse2::xor_delta, sse2::to_rgba,
+};
+
+constinit Kernels const Kernels::avx2 = {
+    ISA::AVX2, "avx2", avx2::hash, avx2::xor_delta, avx2::to_rgba,
+};
+
+constinit Kernels const Kernels::avx512 = {
+    ISA::AVX512, "avx512", avx512::hash, avx512::xor_delta, avx512::to_rgba,
+};
+
+#endif
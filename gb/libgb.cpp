@@ -0,0 +1,178 @@
+#include "libgb.h"
+
+#include <algorithm>
+#include <exception>
+#include <memory>
+#include <new>
+#include <vector>
+
+#include "kernels.hpp"
+#include "machine.hpp"
+#include "metrics.hpp"
+#include "state.hpp"
+
+using namespace gb;
+
+/// Loading swaps in a fresh machine, so a ROM never inherits anything from the previous one
+struct gb_instance {
+    std::unique_ptr<Machine> machine = std::make_unique<Machine>();
+    std::vector<byte_t> boot = {};
+    PPU::Renderer renderer = PPU::Renderer::SCANLINE;
+};
+
+static_assert(GB_SCREEN_WIDTH == PPU::width && GB_SCREEN_HEIGHT == PPU::height);
+static_assert(GB_CLOCK_RATE == clock_rate && GB_FRAME_CYCLES == frame_cycles);
+static_assert(GB_SAMPLE_RATE == APU::sample_rate_default);
+static_assert(GB_STATUS_BREAK == static_cast<int>(CPU::Status::BREAK));
+static_assert(GB_RENDERER_FIFO == static_cast<int>(PPU::Renderer::FIFO));
+
+extern "C" {
+
+int gb_api_version(void) { return GB_API_VERSION; }
+
+gb_instance* gb_create(void) {
+    try {
+        return new gb_instance{};
+    } catch (std::bad_alloc const&) {
+        return nullptr;
+    }
+}
+
+void gb_destroy(gb_instance* gb) { delete gb; }
+
+int gb_set_boot_rom(gb_instance* gb, void const* data, std::size_t size) {
+    if (size && size != Boot::dmg_size && size != Boot::cgb_size) {
+        return -1;
+    }
+    try {
+        auto const bytes = static_cast<byte_t const*>(data);
+        gb->boot.assign(bytes, bytes + size);
+        return 0;
+    } catch (std::bad_alloc const&) {
+        return -1;
+    }
+}
+
+int gb_load_rom(gb_instance* gb, void const* data, std::size_t size) {
+    try {
+        auto machine = std::make_unique<Machine>();
+        Boot::install(machine->mem, gb->boot.data(), gb->boot.size());
+        machine->mem.ppu.renderer = gb->renderer;
+        if (!machine->load(static_cast<byte_t const*>(data), size)) {
+            return -1;
+        }
+        gb->machine = std::move(machine);
+        return 0;
+    } catch (std::bad_alloc const&) {
+        return -1;
+    }
+}
+
+int gb_load_rom_file(gb_instance* gb, char const* path) {
+    try {
+        auto machine = std::make_unique<Machine>();
+        Boot::install(machine->mem, gb->boot.data(), gb->boot.size());
+        machine->mem.ppu.renderer = gb->renderer;
+        if (!machine->load(path)) {
+            return -1;
+        }
+        gb->machine = std::move(machine);
+        return 0;
+    } catch (std::bad_alloc const&) {
+        return -1;
+    }
+}
+
+int gb_set_renderer(gb_instance* gb, int renderer) {
+    if (renderer != GB_RENDERER_SCANLINE && renderer != GB_RENDERER_FIFO) {
+        return -1;
+    }
+    gb->renderer = static_cast<PPU::Renderer>(renderer);
+    gb->machine->mem.video_sync();
+    gb->machine->mem.ppu.set_renderer(gb->renderer);
+    return 0;
+}
+
+int gb_run(gb_instance* gb, std::uint64_t cycles) { return static_cast<int>(gb->machine->run(cycles)); }
+
+int gb_run_frame(gb_instance* gb) {
+    auto const cycles = gb->machine->mem.cycles;
+    return gb_run(gb, frame_cycles - cycles % frame_cycles);
+}
+
+std::uint64_t gb_cycles(gb_instance const* gb) { return gb->machine->mem.cycles; }
+
+int gb_set_buttons(gb_instance* gb, std::uint8_t buttons) {
+    auto& mem = gb->machine->mem;
+    return mem.joypad.push(mem.cycles, buttons) ? 0 : -1;
+}
+
+std::uint32_t const* gb_framebuffer(gb_instance const* gb) { return gb->machine->mem.ppu.framebuffer.data(); }
+
+void gb_framebuffer_rgba(gb_instance const* gb, std::uint8_t* out) {
+    auto const& frame = gb->machine->mem.ppu.framebuffer;
+    Kernels::best().to_rgba(frame.data(), frame.size(), out);
+}
+
+std::int16_t const* gb_audio(gb_instance const* gb, std::size_t* count) {
+    *count = gb->machine->audio.size() / 2;
+    return gb->machine->audio.data();
+}
+
+std::uint8_t const* gb_serial(gb_instance const* gb, std::size_t* size) {
+    *size = gb->machine->serial.size();
+    return reinterpret_cast<std::uint8_t const*>(gb->machine->serial.data());
+}
+
+std::size_t gb_state_size(gb_instance const* gb) { return State::size(gb->machine->cpu, gb->machine->mem); }
+
+std::size_t gb_state_save(gb_instance const* gb, void* out, std::size_t size) {
+    return State::save(gb->machine->cpu, gb->machine->mem, static_cast<byte_t*>(out), size);
+}
+
+int gb_state_load(gb_instance* gb, void const* data, std::size_t size) {
+    return State::load(gb->machine->cpu, gb->machine->mem, static_cast<byte_t const*>(data), size) ? 0 : -1;
+}
+
+int gb_rewind_enable(gb_instance* gb, std::size_t frames, std::size_t budget) {
+    auto& machine = *gb->machine;
+    try {
+        machine.rewind.reset();
+        machine.rewind = std::make_unique<Rewind>(State::size(machine.cpu, machine.mem), frames, budget);
+        return 0;
+    } catch (std::exception const&) {
+        return -1;
+    }
+}
+
+long long gb_rewind(gb_instance* gb, std::size_t frames) {
+    auto& machine = *gb->machine;
+    return machine.rewind ? machine.rewind->rewind(machine.cpu, machine.mem, frames) : -1;
+}
+
+std::size_t gb_rewind_history(gb_instance* gb, std::size_t* bytes) {
+    auto const stats = gb->machine->rewind ? gb->machine->rewind->stats() : Rewind::Stats{};
+    *bytes = stats.bytes;
+    return stats.frames;
+}
+
+std::size_t gb_metrics(gb_instance const* gb, int format, char* out, std::size_t size) {
+    if (format != GB_METRICS_PROMETHEUS && format != GB_METRICS_JSON) {
+        return 0;
+    }
+    try {
+        auto const& mem = gb->machine->mem;
+        auto const metrics = Metrics::snapshot(mem);
+        auto const title = Metrics::title(mem);
+        auto const text = format == GB_METRICS_JSON ? metrics.json(title) : metrics.prometheus(title);
+        if (size) {
+            auto const count = std::min(text.size(), size - 1);
+            std::copy_n(text.data(), count, out);
+            out[count] = '\0';
+        }
+        return text.size();
+    } catch (std::bad_alloc const&) {
+        return 0;
+    }
+}
+}
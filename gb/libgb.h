@@ -0,0 +1,132 @@
+#ifndef GB_LIBGB_H
+#define GB_LIBGB_H
+
+/* C interface of libgb.
+ * Every call takes the instance it works on and the library keeps no state of its own, instances may be driven from
+ * different threads as long as each one is only used by one thread at a time. Pointers handed out stay valid until
+ * the next call that runs, loads or destroys that instance. */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(_WIN32) && defined(GB_SHARED)
+#define GB_API __declspec(dllexport)
+#elif defined(__GNUC__)
+#define GB_API __attribute__((visibility("default")))
+#else
+#define GB_API
+#endif
+
+#define GB_API_VERSION 1
+
+typedef struct gb_instance gb_instance;
+
+/* Result of gb_run */
+enum {
+    GB_STATUS_OK = 0,
+    GB_STATUS_BAD = 1,
+    GB_STATUS_STOP = 2,
+    GB_STATUS_HALT = 3,
+    GB_STATUS_BREAK = 4,
+    GB_STATUS_ERROR = -1
+};
+
+/* Bits of gb_set_buttons */
+enum {
+    GB_BUTTON_RIGHT = 0x01,
+    GB_BUTTON_LEFT = 0x02,
+    GB_BUTTON_UP = 0x04,
+    GB_BUTTON_DOWN = 0x08,
+    GB_BUTTON_A = 0x10,
+    GB_BUTTON_B = 0x20,
+    GB_BUTTON_SELECT = 0x40,
+    GB_BUTTON_START = 0x80
+};
+
+/* Formats of gb_metrics */
+enum { GB_METRICS_PROMETHEUS = 0, GB_METRICS_JSON = 1 };
+
+/* Renderers of gb_set_renderer */
+enum { GB_RENDERER_SCANLINE = 0, GB_RENDERER_FIFO = 1 };
+
+#define GB_SCREEN_WIDTH 160
+#define GB_SCREEN_HEIGHT 144
+#define GB_CLOCK_RATE 4194304
+#define GB_FRAME_CYCLES 70224
+#define GB_SAMPLE_RATE 48000
+
+GB_API int gb_api_version(void);
+
+/* Returns NULL when out of memory */
+GB_API gb_instance* gb_create(void);
+
+GB_API void gb_destroy(gb_instance* gb);
+
+/* Boot ROM (256 byte DMG or 2304 byte CGB image) that later loads run before the cartridge, size 0 goes back to
+ * starting directly in the state it leaves behind. Returns 0 on success. */
+GB_API int gb_set_boot_rom(gb_instance* gb, void const* data, size_t size);
+
+/* Both reset the instance and boot the ROM, return 0 on success */
+GB_API int gb_load_rom(gb_instance* gb, void const* data, size_t size);
+
+GB_API int gb_load_rom_file(gb_instance* gb, char const* path);
+
+/* Scanline renderer (the default) or pixel FIFO renderer for mid-line register changes, applies to the loaded ROM from
+ * the line in progress on and to every later one. Returns 0 on success. */
+GB_API int gb_set_renderer(gb_instance* gb, int renderer);
+
+/* Runs for the given number of base clocks, returns a GB_STATUS value */
+GB_API int gb_run(gb_instance* gb, uint64_t cycles);
+
+/* Runs up to the end of the current video frame */
+GB_API int gb_run_frame(gb_instance* gb);
+
+GB_API uint64_t gb_cycles(gb_instance const* gb);
+
+/* Full pressed state, takes effect at the current cycle, returns -1 if too many changes are queued already */
+GB_API int gb_set_buttons(gb_instance* gb, uint8_t buttons);
+
+/* GB_SCREEN_WIDTH * GB_SCREEN_HEIGHT pixels as 0xAARRGGBB */
+GB_API uint32_t const* gb_framebuffer(gb_instance const* gb);
+
+/* Same pixels as R, G, B, A bytes, out holds GB_SCREEN_WIDTH * GB_SCREEN_HEIGHT * 4 bytes */
+GB_API void gb_framebuffer_rgba(gb_instance const* gb, uint8_t* out);
+
+/* Interleaved stereo samples produced by the last run, count is in sample pairs */
+GB_API int16_t const* gb_audio(gb_instance const* gb, size_t* count);
+
+/* Bytes sent over the serial port during the last run */
+GB_API uint8_t const* gb_serial(gb_instance const* gb, size_t* size);
+
+/* Snapshots exclude the ROM and only load into an instance running the same one */
+GB_API size_t gb_state_size(gb_instance const* gb);
+
+/* Returns bytes written, 0 if size is too small */
+GB_API size_t gb_state_save(gb_instance const* gb, void* out, size_t size);
+
+/* Returns 0 on success, the instance is untouched otherwise */
+GB_API int gb_state_load(gb_instance* gb, void const* data, size_t size);
+
+/* Keeps the last frames frame states, compressed into at most budget bytes, replaces any history */
+GB_API int gb_rewind_enable(gb_instance* gb, size_t frames, size_t budget);
+
+/* Loads the state frames frames back, 0 is the last frame boundary, returns how far it went or -1 */
+GB_API long long gb_rewind(gb_instance* gb, size_t frames);
+
+/* Frames currently in the history, bytes receives their compressed size */
+GB_API size_t gb_rewind_history(gb_instance* gb, size_t* bytes);
+
+/* Counters since the ROM was loaded: instructions, cycles, bank switches, VRAM writes, I/O accesses and runs ended by
+ * BAD, HALT or STOP. Written like snprintf, returns the full length and stores at most size bytes including the
+ * terminating zero, or returns 0 for an unknown format. */
+GB_API size_t gb_metrics(gb_instance const* gb, int format, char* out, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,36 @@
+#include "link.hpp"
+
+using namespace gb;
+
+Link::Link(CPU& cpu_a, CPU::MCB1& mem_a, CPU& cpu_b, CPU::MCB1& mem_b) noexcept
+    : cpu_a(cpu_a), mem_a(mem_a), cpu_b(cpu_b), mem_b(mem_b) {
+    mem_a.serial.tx = &a_to_b;
+    mem_a.serial.rx = &b_to_a;
+    mem_b.serial.tx = &b_to_a;
+    mem_b.serial.rx = &a_to_b;
+}
+
+Link::~Link() {
+    mem_a.serial.tx = mem_a.serial.rx = nullptr;
+    mem_b.serial.tx = mem_b.serial.rx = nullptr;
+}
+
+auto Link::quantum() const noexcept -> std::uint64_t {
+    // CGB fast clock in double speed is the worst case, 8 bits of 8 base clocks each
+    return mem_a.cgb || mem_b.cgb ? 64 : 4096;
+}
+
+auto Link::run(std::uint64_t until) noexcept -> CPU::Status {
+    auto const step = quantum();
+    auto time = std::min(mem_a.cycles, mem_b.cycles);
+    while (time < until) {
+        time = std::min(until, time - time % step + step);
+        if (auto const status = mem_a.run(cpu_a, time); status != CPU::Status::OK) {
+            return status;
+        }
+        if (auto const status = mem_b.run(cpu_b, time); status != CPU::Status::OK) {
+            return status;
+        }
+    }
+    return CPU::Status::OK;
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include "cpu.hpp"
+#include "mcb1.hpp"
+
+/// Link cable between two instances in one process.
+/// Both sides run in lockstep slices no longer than the shortest possible transfer, so a reply is always in the
+/// channel before the clocking side needs it and the outcome does not depend on host timing.
+struct gb::Link final {
+    Serial::Channel a_to_b = {};
+    Serial::Channel b_to_a = {};
+    CPU& cpu_a;
+    CPU::MCB1& mem_a;
+    CPU& cpu_b;
+    CPU::MCB1& mem_b;
+
+    Link(CPU& cpu_a, CPU::MCB1& mem_a, CPU& cpu_b, CPU::MCB1& mem_b) noexcept;
+    Link(Link const&) = delete;
+    Link& operator=(Link const&) = delete;
+    ~Link();
+
+    /// Shortest transfer either side could start, in base clocks
+    auto quantum() const noexcept -> std::uint64_t;
+
+    /// Runs both sides until their cycle counters reach until, stops at the first status that is not OK
+    auto run(std::uint64_t until) noexcept -> CPU::Status;
+};
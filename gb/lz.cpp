@@ -0,0 +1,144 @@
+#include "lz.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace gb;
+
+namespace {
+    auto load32(byte_t const* p) noexcept -> std::uint32_t {
+        auto value = std::uint32_t{};
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    auto load64(byte_t const* p) noexcept -> std::uint64_t {
+        auto value = std::uint64_t{};
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    auto put_length(byte_t*& out, std::size_t length) noexcept -> void {
+        for (; length >= 255; length -= 255) {
+            *out++ = 255;
+        }
+        *out++ = static_cast<byte_t>(length);
+    }
+
+    auto get_length(byte_t const*& in, byte_t const* end, std::size_t& length) noexcept -> bool {
+        for (;;) {
+            if (in == end) {
+                return false;
+            }
+            auto const value = *in++;
+            length += value;
+            if (value != 255) {
+                return true;
+            }
+        }
+    }
+}
+
+auto LZ::compress(byte_t const* src, std::size_t size, byte_t* dst) noexcept -> std::size_t {
+    auto out = dst;
+    auto anchor = std::size_t{};
+    auto const literals = [&](std::size_t end, std::size_t match) {
+        auto const count = end - anchor;
+        *out = static_cast<byte_t>((std::min<std::size_t>(count, 15) << 4) | std::min<std::size_t>(match, 15));
+        ++out;
+        if (count >= 15) {
+            put_length(out, count - 15);
+        }
+        std::memcpy(out, src + anchor, count);
+        out += count;
+    };
+
+    if (size > match_limit) {
+        std::fill(table.begin(), table.end(), 0);
+        auto const limit = size - match_limit;
+        auto const match_end = size - last_literals;
+        auto i = std::size_t{1};
+        while (i < limit) {
+            auto const sequence = load32(src + i);
+            auto& slot = table[(sequence * 2654435761u) >> (32 - hash_bits)];
+            auto const candidate = std::size_t{slot};
+            slot = static_cast<std::uint32_t>(i);
+            if (i - candidate > 0xFFFF || load32(src + candidate) != sequence) {
+                // Skip faster through data that does not compress
+                i += 1 + ((i - anchor) >> 6);
+                continue;
+            }
+            auto length = min_match;
+            while (i + length + 8 <= match_end) {
+                auto const diff = load64(src + i + length) ^ load64(src + candidate + length);
+                if (diff) {
+                    length += static_cast<std::size_t>(std::countr_zero(diff)) / 8;
+                    break;
+                }
+                length += 8;
+            }
+            while (i + length < match_end && src[i + length] == src[candidate + length]) {
+                ++length;
+            }
+            literals(i, length - min_match);
+            auto const offset = i - candidate;
+            *out++ = static_cast<byte_t>(offset);
+            *out++ = static_cast<byte_t>(offset >> 8);
+            if (length - min_match >= 15) {
+                put_length(out, length - min_match - 15);
+            }
+            i += length;
+            anchor = i;
+        }
+    }
+    literals(size, 0);
+    return static_cast<std::size_t>(out - dst);
+}
+
+auto LZ::decompress(byte_t const* src, std::size_t size, byte_t* dst, std::size_t capacity) noexcept -> std::size_t {
+    auto in = src;
+    auto const in_end = src + size;
+    auto out = dst;
+    auto const out_end = dst + capacity;
+    while (in != in_end) {
+        auto const token = *in++;
+        auto count = static_cast<std::size_t>(token >> 4);
+        if (count == 15 && !get_length(in, in_end, count)) {
+            return 0;
+        }
+        if (count > static_cast<std::size_t>(in_end - in) || count > static_cast<std::size_t>(out_end - out)) {
+            return 0;
+        }
+        std::memcpy(out, in, count);
+        in += count;
+        out += count;
+        if (in == in_end) {
+            break;
+        }
+        if (in_end - in < 2) {
+            return 0;
+        }
+        auto const offset = static_cast<std::size_t>(in[0] | in[1] << 8);
+        in += 2;
+        auto length = std::size_t{token & 15u};
+        if (length == 15 && !get_length(in, in_end, length)) {
+            return 0;
+        }
+        length += min_match;
+        if (!offset || offset > static_cast<std::size_t>(out - dst) ||
+            length > static_cast<std::size_t>(out_end - out)) {
+            return 0;
+        }
+        auto from = out - offset;
+        if (offset >= length) {
+            std::memcpy(out, from, length);
+            out += length;
+        } else {
+            // Overlapping copy repeats the last offset bytes
+            for (auto const end = out + length; out != end;) {
+                *out++ = *from++;
+            }
+        }
+    }
+    return static_cast<std::size_t>(out - dst);
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <vector>
+
+#include "common.hpp"
+
+/// LZ4 block format codec.
+/// Greedy single probe matching on 4 byte hashes, tuned for state deltas that are mostly zero runs. The table is part
+/// of the object so every thread compresses with its own.
+struct gb::LZ final {
+    static constexpr int hash_bits = 12;
+    static constexpr std::size_t min_match = 4;
+    static constexpr std::size_t last_literals = 5;
+    static constexpr std::size_t match_limit = 12;
+
+    std::vector<std::uint32_t> table = std::vector<std::uint32_t>(std::size_t{1} << hash_bits);
+
+    /// Worst case output size for size bytes of input
+    gb_func static bound(std::size_t size) noexcept->std::size_t { return size + size / 255 + 16; }
+
+    /// Compresses size bytes of src into dst, which must hold bound(size) bytes, returns the compressed size
+    auto compress(byte_t const* src, std::size_t size, byte_t* dst) noexcept -> std::size_t;
+
+    /// Returns the decompressed size, 0 if src is malformed or does not fit into capacity bytes
+    static auto decompress(byte_t const* src, std::size_t size, byte_t* dst, std::size_t capacity) noexcept
+        -> std::size_t;
+};
@@ -0,0 +1,39 @@
+#include "machine.hpp"
+
+#include <filesystem>
+#include <fstream>
+
+using namespace gb;
+
+auto Machine::load(CPU::MCB1& mem, char const* filename) -> std::size_t {
+    auto error = std::error_code{};
+    auto const size = std::filesystem::file_size(filename, error);
+    if (auto file = std::ifstream(filename, std::ios::binary);
+        error || size > mem.ROM.size() ||
+        !file.read(reinterpret_cast<char*>(mem.ROM.data()), static_cast<std::streamsize>(size))) {
+        return 0;
+    }
+    return size;
+}
+
+auto Machine::run(std::uint64_t count) noexcept -> CPU::Status {
+    audio.clear();
+    serial.clear();
+    auto const until = mem.cycles + count;
+    auto status = CPU::Status::OK;
+    while (status == CPU::Status::OK && mem.cycles < until) {
+        auto const boundary = mem.cycles - mem.cycles % frame_cycles + frame_cycles;
+        auto const frame_end = std::min(until, boundary);
+        status = mem.run(cpu, frame_end);
+        mem.video_sync();
+        mem.apu.end_frame(mem.cycles);
+        auto const offset = audio.size();
+        audio.resize(offset + mem.apu.samples_avail() * 2);
+        audio.resize(offset + mem.apu.read_samples(audio.data() + offset, (audio.size() - offset) / 2) * 2);
+        if (rewind && frame_end == boundary && status == CPU::Status::OK) {
+            rewind->capture(cpu, mem);
+        }
+    }
+    mem.serial.flush();
+    return status;
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "arena.hpp"
+#include "boot.hpp"
+#include "cpu.hpp"
+#include "mcb1.hpp"
+#include "rewind.hpp"
+
+/// One complete emulator instance with its output collected in memory.
+/// Everything lives in the object itself, so any number of machines can run side by side, each on its own thread.
+/// Heap allocated machines get an Arena block of their own, the CPU registers directly precede the hot fields of
+/// MCB1 there.
+struct gb::Machine final {
+    CPU cpu = {};
+    CPU::MCB1 mem = {};
+
+    /// Output of the last run() call, interleaved stereo samples and serial bytes
+    std::vector<std::int16_t> audio = {};
+    std::string serial = {};
+
+    /// Optional history, captured at every frame boundary run() crosses
+    std::unique_ptr<Rewind> rewind = {};
+
+    Machine() {
+        mem.serial.callback = [this](std::string_view text) { serial.append(text); };
+    }
+    Machine(Machine const&) = delete;
+    Machine& operator=(Machine const&) = delete;
+
+    static auto operator new(std::size_t size) -> void* {
+        if (auto const block = Arena::allocate(size)) {
+            return block;
+        }
+        throw std::bad_alloc{};
+    }
+
+    static auto operator delete(void* block, std::size_t size) noexcept -> void { Arena::release(block, size); }
+
+    /// Reads ROM image into mem, returns its size or 0 on failure, images larger than mem.ROM included
+    static auto load(CPU::MCB1& mem, char const* filename) -> std::size_t;
+
+    /// Copies ROM image into a freshly constructed machine, looks for idle loops and starts it through Boot. Returns
+    /// false if it is empty or larger than mem.ROM.
+    auto load(byte_t const* data, std::size_t size) noexcept -> bool {
+        if (!size || size > mem.ROM.size()) {
+            return false;
+        }
+        std::copy_n(data, size, mem.ROM.begin());
+        mem.find_idle_loops(size);
+        Boot::start(cpu, mem);
+        return true;
+    }
+
+    auto load(char const* filename) -> bool {
+        auto const size = load(mem, filename);
+        if (!size) {
+            return false;
+        }
+        mem.find_idle_loops(size);
+        Boot::start(cpu, mem);
+        return true;
+    }
+
+    /// Runs for the given number of base clocks, ending an audio frame at every video frame boundary on the way
+    auto run(std::uint64_t count) noexcept -> CPU::Status;
+};
@@ -1,119 +1,713 @@
 #pragma once
+#include <algorithm>
 #include <cstdio>
+#include <cstring>
+#include <limits>
 
+#include "apu.hpp"
 #include "cpu_bus.hpp"
+#include "debugger.hpp"
+#include "header.hpp"
+#include "joypad.hpp"
+#include "metrics.hpp"
+#include "ppu.hpp"
+#include "save.hpp"
+#include "serial.hpp"
 
 struct gb::CPU::MCB1 final : gb::CPU::BUS {
-    std::array<byte_t, 0x140000> ROM = {};
-    std::array<byte_t, 0x2000> VRAM = {};
-    std::array<byte_t, 0x8000> WRAM = {};
-    std::array<byte_t, 0x8000> ERAM = {};
-    std::array<byte_t, 0x80> HRAM = {};
+    static constexpr std::uint64_t never = std::numeric_limits<std::uint64_t>::max();
+
+    // Fields are ordered by how often they are touched. Everything a plain memory access or the run() loop needs sits
+    // in the first two cache lines behind the vtable pointer, the large arrays come last. Machine keeps the CPU
+    // registers in the line right before.
+
+    std::uint64_t cycles = {};
+
+    /// Earliest cycle at which events() has work to do, checked only between instructions
+    std::uint64_t event_deadline = never;
+
+    /// Host pointers to currently switched banks, rebuilt by remap() whenever a bank register changes
+    byte_t* rom0_page = {};
+    byte_t* rom_page = {};
+    byte_t* vram_page = {};
+    byte_t* wram_page = {};
+    byte_t* eram_page = {};
+
+    /// CGB mode, speed switch only changes how many base clocks one memory cycle takes
+    byte_t cycle_step = 4;
+    bool cgb = {};
+    bool double_speed = {};
+    bool speed_prepare = {};
 
     bool eram_enable = {};
     bool mode = {};
-    byte_t rom_bank = {};
-    byte_t eram_bank = 1;
+    /// BANK1 in bits 0 - 4 and BANK2 in bits 5 - 6, MBC1 powers up with bank 1 at 0x4000. BANK2 always extends the
+    /// bank at 0x4000, mode 1 also applies it to 0x0000 and uses it as the ERAM bank, which is bank 0 in mode 0.
+    byte_t rom_bank = 1;
     byte_t wram_bank = {};
-    char serial = {};
+    byte_t vram_bank = {};
+
+    /// Boot ROM seen at 0x0000 - 0x00FF, and 0x0200 - 0x08FF for CGB, until the first non-zero write to 0xFF50
+    bool boot_mapped = {};
+    std::size_t boot_size = {};
+
+    /// OAM DMA, the copy itself is done at once and only the bus conflict lasts until dma_until
+    std::uint64_t dma_until = {};
+    byte_t dma_source = {};
+
+    /// Pages holding read and write points, copied from debugger by run(), which only switches to the Watched bus
+    /// while any is set
+    Debugger::Pages watch_reads = {};
+    Debugger::Pages watch_writes = {};
+    bool watching = {};
+
+    /// Optional, only consulted while it holds at least one point
+    Debugger* debugger = {};
+
+    /// Entry points of LY polling loops, see idle_skip(), and the CPU and end of the run() call in progress
+    std::array<word_t, 16> idle_loops = {};
+    std::size_t idle_count = {};
+    CPU const* running = {};
+    std::uint64_t running_until = {};
+
+    /// Backing store of ERAM, points into a mapped save file while one is attached
+    byte_t* eram_data = ERAM.data();
+    std::size_t eram_size = ERAM.size();
+    Save* save = {};
+
+    Metrics metrics = {};
+
+    std::array<byte_t, 0x80> HRAM = {};
+    std::array<byte_t, 0xA0> OAM = {};
+
+    /// HDMA / GDMA
+    word_t hdma_source = {};
+    word_t hdma_dest = {};
+    byte_t hdma_length = 0xFF;
+    bool hdma_active = {};
+    std::uint64_t hdma_next = never;
+
+    Joypad joypad = {};
+    std::uint64_t joypad_next = never;
+    Serial serial = {};
+    std::uint64_t serial_next = never;
+    APU apu = APU{};
+    PPU ppu = PPU{};
+
+    std::array<byte_t, 0x4000> VRAM = {};
+    std::array<byte_t, 0x8000> WRAM = {};
+    std::array<byte_t, 0x8000> ERAM = {};
+    std::array<byte_t, 0x900> BOOT = {};
+    std::array<byte_t, 0x140000> ROM = {};
+
+    MCB1() noexcept { remap(); }
+    MCB1(MCB1 const&) = delete;
+    MCB1& operator=(MCB1 const&) = delete;
+
+    gb_func remap() noexcept->void {
+        rom0_page = &ROM[(mode ? (rom_bank & 0x60) * 0x4000 : 0) % ROM.size()];
+        rom_page = &ROM[(rom_bank * 0x4000) % ROM.size()];
+        vram_page = &VRAM[(vram_bank & 1) * 0x2000];
+        wram_page = &WRAM[std::max(wram_bank & 7, 1) * 0x1000];
+        eram_page = &eram_data[(mode ? (rom_bank >> 5) * 0x2000 : 0) % eram_size];
+    }
+
+    gb_func boot_covers(word_t address) const noexcept->bool {
+        return boot_mapped && (address < 0x100 || (address >= 0x200 && address < boot_size));
+    }
+
+    gb_func set_cgb(bool enable) noexcept->void {
+        cgb = enable;
+        ppu.cgb = enable;
+        serial.cgb = enable;
+    }
+
+    /// Switches CPU speed, called when STOP executes with the switch armed through KEY1
+    gb_func speed_switch() noexcept->void {
+        double_speed = !double_speed;
+        speed_prepare = false;
+        cycle_step = double_speed ? 2 : 4;
+    }
+
+    /// Renders pending lines before anything they depend on changes
+    gb_func video_sync() noexcept->void { ppu.run_until(cycles, VRAM.data(), OAM.data()); }
+
+    /// Fills idle_loops with every "ldh a,(0x44); cp n; jr cc,-6" in the first size bytes of ROM, as CPU addresses
+    gb_func find_idle_loops(std::size_t size) noexcept->void {
+        idle_count = 0;
+        size = std::min(size, ROM.size());
+        for (auto i = std::size_t{}; i + 6 <= size && idle_count != idle_loops.size(); ++i) {
+            if (ROM[i] == 0xF0 && ROM[i + 1] == 0x44 && ROM[i + 2] == 0xFE && ROM[i + 5] == 0xFA &&
+                one_of(ROM[i + 4], 0x20, 0x28, 0x30, 0x38) && (i & 0x3FFF) <= 0x3FFA) {
+                auto const address = static_cast<word_t>(i < 0x4000 ? i : 0x4000 | (i & 0x3FFF));
+                if (std::find(idle_loops.begin(), idle_loops.begin() + idle_count, address) ==
+                    idle_loops.begin() + idle_count) {
+                    idle_loops[idle_count++] = address;
+                }
+            }
+        }
+    }
+
+    /// Called on LY reads. When the read belongs to a listed polling loop, every iteration that would still read a
+    /// value that keeps the loop going is skipped at once and this read returns the first value that ends it. Only
+    /// whole iterations that would have run before the end of the slice and the next event are skipped, and nothing
+    /// but A and F changes inside them, so the machine ends up exactly where stepping would have taken it.
+    gb_func idle_skip() noexcept->void {
+        if (!running || cycles < dma_until || (debugger && debugger->armed())) {
+            return;
+        }
+        auto const pc = static_cast<word_t>(running->reg_ip - 2);
+        if (std::find(idle_loops.begin(), idle_loops.begin() + idle_count, pc) == idle_loops.begin() + idle_count) {
+            return;
+        }
+        // Banks may have switched since the scan, the code at pc has to match now
+        byte_t code[6] = {};
+        for (auto i = 0; i != 6; ++i) {
+            code[i] = peek(static_cast<word_t>(pc + i));
+        }
+        if (code[0] != 0xF0 || code[1] != 0x44 || code[2] != 0xFE || code[5] != 0xFA ||
+            !one_of(code[4], 0x20, 0x28, 0x30, 0x38)) {
+            return;
+        }
+        auto const ends = [&](byte_t ly) {
+            switch (code[4]) {
+                case 0x20:
+                    return ly == code[3];
+                case 0x28:
+                    return ly != code[3];
+                case 0x30:
+                    return ly < code[3];
+                default:
+                    return ly >= code[3];
+            }
+        };
+        // ldh, cp and a taken jr take 8 memory cycles, the read is the third of them
+        auto const period = std::uint64_t{8} * cycle_step;
+        auto const start = cycles - 3 * cycle_step;
+        auto const limit = std::min(running_until, event_deadline);
+        if (start + period >= limit) {
+            return;
+        }
+        auto const last = (limit - 1 - start) / period;
+        auto count = std::uint64_t{};
+        while (count < last) {
+            auto const at = cycles + count * period;
+            if (ends(ppu.read(at, 0xFF44))) {
+                break;
+            }
+            // LY holds until the next line
+            auto const next = at - at % PPU::line_cycles + PPU::line_cycles;
+            count = std::min(last, count + (next - at + period - 1) / period);
+        }
+        cycles += count * period;
+        metrics.instructions += count * 3;
+        metrics.io_reads += count;
+        metrics.idle_cycles += count * period;
+    }
+
+    /// Bus seen by CPU while OAM DMA is running, everything except HRAM and I/O is inaccessible
+    struct Conflict final : BUS {
+        MCB1& mem;
+
+        constexpr explicit Conflict(MCB1& mem) noexcept : mem(mem) {}
+
+        gb_func virtual read_byte(word_t address) noexcept->byte_t override {
+            if (address >= 0xFF00) {
+                return mem.watching ? mem.read_watched(address) : mem.read_byte(address);
+            }
+            mem.waste();
+            return 0xFF;
+        }
+
+        gb_func virtual write_byte(word_t address, byte_t value) noexcept->void override {
+            if (address >= 0xFF00) {
+                return mem.watching ? mem.write_watched(address, value) : mem.write_byte(address, value);
+            }
+            mem.waste();
+        }
+
+        gb_func virtual waste() noexcept->void override { mem.waste(); }
+    };
+
+    /// Bus seen by CPU while read or write points are set, the plain bus never tests the watch bitmaps
+    struct Watched final : BUS {
+        MCB1& mem;
+
+        constexpr explicit Watched(MCB1& mem) noexcept : mem(mem) {}
+
+        gb_func virtual read_byte(word_t address) noexcept->byte_t override { return mem.read_watched(address); }
+
+        gb_func virtual write_byte(word_t address, byte_t value) noexcept->void override {
+            mem.write_watched(address, value);
+        }
+
+        gb_func virtual waste() noexcept->void override { mem.waste(); }
+    };
+
+    /// Host pointer to the byte at address as seen by DMA, valid up to the end of its 256 byte page
+    gb_func dma_page(word_t address) noexcept->byte_t const* {
+        switch ((address >> 12) & 0xF) {
+            case 0x0:
+                if (boot_covers(address)) [[unlikely]] {
+                    return &BOOT[address];
+                }
+                [[fallthrough]];
+            case 0x1:
+            case 0x2:
+            case 0x3:
+                return &rom0_page[address & 0x3FFF];
+            case 0x4:
+            case 0x5:
+            case 0x6:
+            case 0x7:
+                return &rom_page[address & 0x3FFF];
+            case 0x8:
+            case 0x9:
+                return &vram_page[address & 0x1FFF];
+            case 0xA:
+            case 0xB:
+                return eram_enable ? &eram_page[address & 0x1FFF] : nullptr;
+            case 0xC:
+            case 0xE:
+                return &WRAM[address & 0xFFF];
+            default:
+                return &wram_page[address & 0xFFF];
+        }
+    }
+
+    /// Side effect free read for debuggers and tracing
+    gb_func peek(word_t address) noexcept->byte_t {
+        if (address < 0xFE00) {
+            auto const page = dma_page(address);
+            return page ? *page : 0xFF;
+        } else if (address < 0xFEA0) {
+            return OAM[address - 0xFE00];
+        } else if (address >= 0xFF80 && address != 0xFFFF) {
+            return HRAM[address - 0xFF80];
+        }
+        return 0xFF;
+    }
+
+    /// Side effect free write for debuggers, ROM included and MBC registers untouched
+    gb_func poke(word_t address, byte_t value) noexcept->void {
+        if (address < 0xFE00) {
+            if (auto const page = dma_page(address)) {
+                // Every page dma_page hands out belongs to one of our own arrays
+                const_cast<byte_t&>(*page) = value;
+                if (save && address >= 0xA000 && address < 0xC000) {
+                    save->mark(static_cast<std::size_t>(page - eram_data));
+                }
+            }
+        } else if (address < 0xFEA0) {
+            OAM[address - 0xFE00] = value;
+        } else if (address >= 0xFF80 && address != 0xFFFF) {
+            HRAM[address - 0xFF80] = value;
+        }
+    }
+
+    /// Copies size bytes starting at bus address src, one memcpy per source page
+    gb_func dma_copy(byte_t* dst, word_t src, std::size_t size) noexcept->void {
+        while (size) {
+            auto const chunk = std::min<std::size_t>(size, 0x100 - (src & 0xFF));
+            if (auto const page = dma_page(src)) {
+                std::memcpy(dst, page, chunk);
+            } else {
+                std::memset(dst, 0xFF, chunk);
+            }
+            dst += chunk;
+            src += static_cast<word_t>(chunk);
+            size -= chunk;
+        }
+    }
+
+    gb_func dma_start(byte_t value) noexcept->void {
+        video_sync();
+        dma_source = value;
+        dma_copy(OAM.data(), static_cast<word_t>(value << 8), OAM.size());
+        dma_until = cycles + 160 * cycle_step;
+        event_deadline = cycles;
+    }
+
+    /// Moves one 16 byte HDMA block into VRAM, CPU is stalled while it happens
+    gb_func hdma_block() noexcept->void {
+        video_sync();
+        dma_copy(&vram_page[hdma_dest & 0x1FF0], hdma_source, 0x10);
+        hdma_source += 0x10;
+        hdma_dest = (hdma_dest + 0x10) & 0x1FF0;
+        cycles += 8 * 4;
+        if (hdma_length-- == 0) {
+            hdma_active = false;
+        }
+    }
+
+    /// Start of the next horizontal blank at or after given cycle
+    gb_func hblank_after(std::uint64_t at) noexcept->std::uint64_t {
+        auto const frame = at - at % frame_cycles;
+        auto const line = (at - frame) / PPU::line_cycles;
+        auto const dot = (at - frame) % PPU::line_cycles;
+        if (line < PPU::height && dot <= PPU::hblank_dot) {
+            return frame + line * PPU::line_cycles + PPU::hblank_dot;
+        } else if (line + 1 < PPU::height) {
+            return frame + (line + 1) * PPU::line_cycles + PPU::hblank_dot;
+        }
+        return frame + frame_cycles + PPU::hblank_dot;
+    }
+
+    gb_func hdma_start(byte_t value) noexcept->void {
+        if (hdma_active && !(value & 0x80)) {
+            hdma_active = false;
+            hdma_length |= 0x80;
+            return;
+        }
+        hdma_length = value & 0x7F;
+        if (value & 0x80) {
+            hdma_active = true;
+            hdma_next = hblank_after(cycles);
+            event_deadline = std::min(event_deadline, hdma_next);
+            return;
+        }
+        auto const size = (hdma_length + 1u) * 0x10;
+        auto const dest = hdma_dest & 0x1FF0;
+        auto const first = std::min(size, 0x2000u - dest);
+        video_sync();
+        dma_copy(&vram_page[dest], hdma_source, first);
+        dma_copy(&vram_page[0], static_cast<word_t>(hdma_source + first), size - first);
+        hdma_source += static_cast<word_t>(size);
+        hdma_dest = static_cast<word_t>((dest + size) & 0x1FF0);
+        hdma_length = 0xFF;
+        cycles += size / 0x10 * 8 * 4;
+    }
+
+    /// Services everything that became due, called between instructions once cycles reach event_deadline
+    gb_func events() noexcept->void {
+        event_deadline = never;
+        if (cycles < dma_until) {
+            event_deadline = dma_until;
+        }
+        while (hdma_active && hdma_next <= cycles) {
+            hdma_block();
+            hdma_next = hblank_after(hdma_next + 1);
+        }
+        if (hdma_active) {
+            event_deadline = std::min(event_deadline, hdma_next);
+        }
+        if (joypad_next <= cycles) {
+            joypad_next = joypad.apply(cycles);
+        }
+        event_deadline = std::min(event_deadline, joypad_next);
+        if (serial_next <= cycles) {
+            serial_next = serial.apply(cycles);
+        }
+        event_deadline = std::min(event_deadline, serial_next);
+    }
+
+    /// Runs CPU until cycles reaches until or CPU stops, bus is switched only at instruction boundaries.
+    /// Host input and link cable messages queued before the call are picked up here and nowhere else.
+    auto run(CPU& cpu, std::uint64_t until) noexcept -> Status {
+        running = &cpu;
+        running_until = until;
+        joypad.latch();
+        joypad_next = joypad.next_cycle();
+        event_deadline = std::min(event_deadline, joypad_next);
+        serial.latch();
+        serial_next = serial.next_cycle();
+        event_deadline = std::min(event_deadline, serial_next);
+        auto const slice = [&](BUS& bus) {
+            auto executed = std::uint64_t{};
+            while (cycles < until && cycles < event_deadline) {
+                ++executed;
+                if (auto const status = cpu.step(bus); status != Status::OK) [[unlikely]] {
+                    metrics.instructions += executed;
+                    return status;
+                }
+            }
+            metrics.instructions += executed;
+            return Status::OK;
+        };
+        // Same loop for execution points, the debugger is only asked about instructions on a marked page
+        auto const slice_exec = [&](BUS& bus) {
+            auto executed = std::uint64_t{};
+            auto status = Status::OK;
+            while (cycles < until && cycles < event_deadline) {
+                if (debugger->exec_pages.test(cpu.reg_ip) && debugger->exec(cpu, rom_bank, *this)) [[unlikely]] {
+                    status = Status::BREAK;
+                    break;
+                }
+                ++executed;
+                if (status = cpu.step(bus); status != Status::OK) [[unlikely]] {
+                    break;
+                }
+            }
+            metrics.instructions += executed;
+            return status;
+        };
+        // Watched accesses end the slice through event_deadline when a point triggers
+        auto const armed = debugger && debugger->armed();
+        watch_reads = armed ? debugger->read_pages : Debugger::Pages{};
+        watch_writes = armed ? debugger->write_pages : Debugger::Pages{};
+        watching = watch_reads.any() || watch_writes.any();
+        auto const breaks = armed && debugger->exec_pages.any();
+        if (armed) {
+            debugger->cpu = &cpu;
+            debugger->triggered = false;
+            // Stepping over the point stopped at only applies while still on it
+            debugger->step_over &= debugger->exec_pages.test(cpu.reg_ip);
+        }
+        while (true) {
+            if (cycles >= event_deadline) {
+                events();
+            }
+            if (cycles >= until) {
+                return Status::OK;
+            }
+            auto conflict = Conflict{*this};
+            auto watched = Watched{*this};
+            auto& plain = watching ? static_cast<BUS&>(watched) : static_cast<BUS&>(*this);
+            auto& bus = cycles < dma_until ? static_cast<BUS&>(conflict) : plain;
+            auto const status = breaks ? slice_exec(bus) : slice(bus);
+            metrics.count(status);
+            if (status == Status::STOP && cgb && speed_prepare) {
+                speed_switch();
+                continue;
+            }
+            if (status != Status::OK) {
+                return status;
+            }
+            if (armed && debugger->triggered) [[unlikely]] {
+                return Status::BREAK;
+            }
+        }
+    }
+
+    /// I/O registers in 0xFF00 - 0xFF7F
+    gb_func io_read(word_t address) noexcept->byte_t {
+        if (address == 0xFF00) {
+            return joypad.read();
+        } else if (address == 0xFF01 || address == 0xFF02) {
+            return serial.read(address);
+        } else if (address >= 0xFF10 && address < 0xFF40) {
+            return apu.read(cycles, address);
+        } else if (address == 0xFF46) {
+            return dma_source;
+        } else if ((address >= 0xFF40 && address < 0xFF4C) || (address >= 0xFF68 && address < 0xFF6C)) {
+            if (address == 0xFF44 && idle_count) {
+                idle_skip();
+            }
+            return ppu.read(cycles, address);
+        } else if (!cgb) {
+            // Everything below only exists on CGB
+        } else if (address == 0xFF4D) {
+            return static_cast<byte_t>(0x7E | (double_speed << 7) | speed_prepare);
+        } else if (address == 0xFF4F) {
+            return static_cast<byte_t>(0xFE | vram_bank);
+        } else if (address == 0xFF55) {
+            return hdma_length;
+        } else if (address == 0xFF70) {
+            return static_cast<byte_t>(0xF8 | wram_bank);
+        }
+        return 0xFF;
+    }
+
+    gb_func io_write(word_t address, byte_t value) noexcept->void {
+        if (address == 0xFF00) {
+            joypad.write(value);
+        } else if (address == 0xFF01 || address == 0xFF02) {
+            serial_next = serial.write(cycles, address, value, cycle_step);
+            event_deadline = std::min(event_deadline, serial_next);
+        } else if (address >= 0xFF10 && address < 0xFF40) {
+            apu.write(cycles, address, value);
+        } else if (address == 0xFF46) {
+            dma_start(value);
+        } else if ((address >= 0xFF40 && address < 0xFF4C) || (address >= 0xFF68 && address < 0xFF6C)) {
+            video_sync();
+            ppu.write(address, value);
+        } else if (address == 0xFF50) {
+            if (boot_mapped && value) {
+                // CGB boot ROM locks in DMG or CGB mode from the cartridge header on the way out
+                boot_mapped = false;
+                if (boot_size == 0x900) {
+                    set_cgb(Header::parse(ROM.data(), Header::end).cgb);
+                }
+            }
+        } else if (!cgb) {
+            // Everything below only exists on CGB
+        } else if (address == 0xFF4D) {
+            speed_prepare = value & 1;
+        } else if (address == 0xFF4F) {
+            vram_bank = value & 1;
+            ++metrics.bank_switches;
+            remap();
+        } else if (address == 0xFF70) {
+            wram_bank = value & 7;
+            ++metrics.bank_switches;
+            remap();
+        } else if (address == 0xFF51) {
+            hdma_source = static_cast<word_t>((hdma_source & 0x00F0) | (value << 8));
+        } else if (address == 0xFF52) {
+            hdma_source = static_cast<word_t>((hdma_source & 0xFF00) | (value & 0xF0));
+        } else if (address == 0xFF53) {
+            hdma_dest = static_cast<word_t>((hdma_dest & 0x00F0) | ((value & 0x1F) << 8));
+        } else if (address == 0xFF54) {
+            hdma_dest = static_cast<word_t>((hdma_dest & 0x1F00) | (value & 0xF0));
+        } else if (address == 0xFF55) {
+            hdma_start(value);
+        }
+    }
 
     gb_func virtual read_byte(word_t address) noexcept->byte_t override {
+        cycles += cycle_step;
+        return load(address);
+    }
+
+    gb_func virtual write_byte(word_t address, byte_t value) noexcept->void override {
+        cycles += cycle_step;
+        store(address, value);
+    }
+
+    gb_func virtual waste() noexcept->void override { cycles += cycle_step; }
+
+    /// read_byte and write_byte with the watch bitmaps consulted, the debugger only sees accesses to marked pages
+    gb_func read_watched(word_t address) noexcept->byte_t {
+        cycles += cycle_step;
+        auto const value = load(address);
+        if (watch_reads.test(address)) [[unlikely]] {
+            watched(Debugger::Kind::READ, address, value);
+        }
+        return value;
+    }
+
+    gb_func write_watched(word_t address, byte_t value) noexcept->void {
+        cycles += cycle_step;
+        store(address, value);
+        if (watch_writes.test(address)) [[unlikely]] {
+            watched(Debugger::Kind::WRITE, address, value);
+        }
+    }
+
+    /// Access on a page with points, one that triggers ends the slice once the instruction is done
+    gb_func watched(Debugger::Kind kind, word_t address, byte_t value) noexcept->void {
+        if (debugger && debugger->match(kind, address, value, rom_bank, *this)) {
+            event_deadline = cycles;
+        }
+    }
+
+    /// CPU view of memory behind read_byte, the clock is advanced by the caller
+    gb_func load(word_t address) noexcept->byte_t {
         switch ((address >> 12) & 0xF) {
             case 0x0:
+                if (boot_covers(address)) [[unlikely]] {
+                    return BOOT[address];
+                }
+                [[fallthrough]];
             case 0x1:
             case 0x2:
             case 0x3:
-                return ROM[address & 0x3FFF];
+                return rom0_page[address & 0x3FFF];
             case 0x4:
             case 0x5:
             case 0x6:
             case 0x7:
-                return ROM[(rom_bank * 0x4000) + (address & 0x3FFF)];
+                return rom_page[address & 0x3FFF];
             case 0x8:
             case 0x9:
-                return VRAM[address & 0x1FFF];
+                return vram_page[address & 0x1FFF];
             case 0xA:
             case 0xB:
                 if (eram_enable) {
-                    return ERAM[eram_bank * 0x2000 + (address & 0x1FFF)];
+                    return eram_page[address & 0x1FFF];
                 } else {
                     return 0xFF;
                 }
             case 0xC:
                 return WRAM[address & 0xFFF];
             case 0xD:
-                return WRAM[(wram_bank * 0x1000) + (address & 0x1FFF)];
+                return wram_page[address & 0xFFF];
             case 0xE:
                 return WRAM[address & 0xFFF];
             case 0xF:
                 if (address < 0xFE00) {
-                    return WRAM[(wram_bank * 0x1000) + (address & 0x1FFF)];
-                } else if (address == 0xFF44) {
-                    return 0x90;
+                    return wram_page[address & 0xFFF];
+                } else if (address < 0xFEA0) {
+                    return OAM[address & 0xFF];
                 } else if (address >= 0xFF80) {
                     return HRAM[address & 0x7F];
+                } else if (address >= 0xFF00) {
+                    ++metrics.io_reads;
+                    return io_read(address);
                 }
                 break;
         }
         return 0xFF;
-    };
+    }
 
-    gb_func virtual write_byte(word_t address, byte_t value) noexcept->void override {
+    /// CPU writes behind write_byte, the clock is advanced by the caller
+    gb_func store(word_t address, byte_t value) noexcept->void {
         switch ((address >> 12) & 0xF) {
             case 0x0:
-            case 0x1:
-                eram_enable = (value & 0xF) == 0xA;
+            case 0x1: {
+                auto const enable = (value & 0xF) == 0xA;
+                if (save && eram_enable && !enable) {
+                    save->request();
+                }
+                eram_enable = enable;
                 break;
+            }
             case 0x2:
             case 0x3:
                 rom_bank &= 0x60;
                 rom_bank |= std::max(value & 0x1F, 1);
+                ++metrics.bank_switches;
+                remap();
                 break;
             case 0x4:
             case 0x5:
-                if (mode) {
-                    eram_bank = (value & 0x3) + 1;
-                } else {
-                    rom_bank &= 0x1F;
-                    rom_bank |= (value & 0x3) << 5;
-                }
+                rom_bank &= 0x1F;
+                rom_bank |= (value & 0x3) << 5;
+                ++metrics.bank_switches;
+                remap();
                 break;
             case 0x6:
             case 0x7:
                 mode = value & 1;
+                remap();
                 break;
             case 0x8:
             case 0x9:
-                VRAM[address & 0x1FFF] = value;
+                ++metrics.vram_writes;
+                video_sync();
+                vram_page[address & 0x1FFF] = value;
                 break;
             case 0xA:
             case 0xB:
                 if (eram_enable) {
-                    ERAM[eram_bank * 0x2000 + (address & 0x1FFF)] = value;
+                    eram_page[address & 0x1FFF] = value;
+                    if (save) {
+                        save->mark(static_cast<std::size_t>(&eram_page[address & 0x1FFF] - eram_data));
+                    }
                 }
                 break;
             case 0xC:
                 WRAM[address & 0xFFF] = value;
                 break;
             case 0xD:
-                WRAM[(wram_bank * 0x1000) + (address & 0x1FFF)] = value;
+                wram_page[address & 0xFFF] = value;
                 break;
             case 0xE:
                 WRAM[address & 0xFFF] = value;
                 break;
             case 0xF:
                 if (address < 0xFE00) {
-                    WRAM[(wram_bank * 0x1000) + (address & 0x1FFF)] = value;
+                    wram_page[address & 0xFFF] = value;
+                } else if (address < 0xFEA0) {
+                    video_sync();
+                    OAM[address & 0xFF] = value;
                 } else if (address >= 0xFF80) {
                     HRAM[address & 0x7F] = value;
-                } else if (address == 0xFF01) {
-                    serial = static_cast<char>(value);
-                } else if (address == 0xFF02 && value == 0x81) {
-                    printf("%c", serial);
+                } else if (address >= 0xFF00) {
+                    ++metrics.io_writes;
+                    io_write(address, value);
                 }
                 break;
         }
-    };
-
-    gb_func virtual waste() noexcept->void override {}
+    }
 };
@@ -0,0 +1,76 @@
+#include "metrics.hpp"
+
+#include "mcb1.hpp"
+
+using namespace gb;
+
+namespace {
+    struct Field {
+        char const* name;
+        char const* help;
+        std::uint64_t Metrics::* value;
+    };
+
+    constexpr Field fields[] = {
+        {"instructions", "Instructions executed", &Metrics::instructions},
+        {"cycles", "Base clocks emulated", &Metrics::cycles},
+        {"bank_switches", "Writes to ROM, ERAM, VRAM and WRAM bank registers", &Metrics::bank_switches},
+        {"vram_writes", "CPU writes to VRAM", &Metrics::vram_writes},
+        {"io_reads", "CPU reads of I/O registers", &Metrics::io_reads},
+        {"io_writes", "CPU writes to I/O registers", &Metrics::io_writes},
+        {"bad", "Runs stopped by an unused opcode", &Metrics::bad},
+        {"halt", "Runs stopped by HALT", &Metrics::halt},
+        {"stop", "Runs stopped by STOP", &Metrics::stop},
+        {"idle_cycles", "Base clocks fast-forwarded through LY polling loops", &Metrics::idle_cycles},
+    };
+
+    /// Titles are printable ASCII already, only quotes and backslashes need escaping in both formats
+    auto quoted(std::string_view text) -> std::string {
+        auto result = std::string(1, '"');
+        for (auto const c : text) {
+            if (c == '"' || c == '\\') {
+                result += '\\';
+            }
+            result += c;
+        }
+        return result += '"';
+    }
+}
+
+auto Metrics::snapshot(CPU::MCB1 const& mem) noexcept -> Metrics {
+    auto result = mem.metrics;
+    result.cycles = mem.cycles;
+    return result;
+}
+
+auto Metrics::title(CPU::MCB1 const& mem) -> std::string {
+    auto result = std::string{};
+    for (auto address = 0x134; address != 0x144; ++address) {
+        auto const c = mem.ROM[static_cast<std::size_t>(address)];
+        if (c < 0x20 || c > 0x7E) {
+            break;
+        }
+        result += static_cast<char>(c);
+    }
+    return result;
+}
+
+auto Metrics::prometheus(std::string_view rom) const -> std::string {
+    auto const label = "{rom=" + quoted(rom) + "} ";
+    auto result = std::string{};
+    for (auto const& field : fields) {
+        auto const name = std::string("gb_") + field.name + "_total";
+        result += "# HELP " + name + " " + field.help + "\n";
+        result += "# TYPE " + name + " counter\n";
+        result += name + label + std::to_string(this->*field.value) + "\n";
+    }
+    return result;
+}
+
+auto Metrics::json(std::string_view rom) const -> std::string {
+    auto result = "{\"rom\":" + quoted(rom);
+    for (auto const& field : fields) {
+        result += std::string(",\"") + field.name + "\":" + std::to_string(this->*field.value);
+    }
+    return result += "}\n";
+}
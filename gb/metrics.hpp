@@ -0,0 +1,59 @@
+#pragma once
+#include <string>
+#include <string_view>
+
+#include "cpu.hpp"
+
+/// Counters of what a machine spent its time on, cheap enough to stay on in production.
+/// Each MCB1 owns one block and only the thread running it writes to it with plain adds, so the block is padded to
+/// its own cache line instead of paying for atomics. Instructions are added once per slice of run(), everything else
+/// is counted where it happens on the bus. snapshot() adds the cycle count on demand, blocks of several machines can
+/// be summed and either one exported as Prometheus text or JSON.
+struct alignas(64) gb::Metrics final {
+    std::uint64_t instructions = {};
+    std::uint64_t cycles = {};
+    std::uint64_t bank_switches = {};
+    std::uint64_t vram_writes = {};
+    std::uint64_t io_reads = {};
+    std::uint64_t io_writes = {};
+    std::uint64_t bad = {};
+    std::uint64_t halt = {};
+    std::uint64_t stop = {};
+    std::uint64_t idle_cycles = {};
+
+    /// Counts a run() that ended with status
+    gb_func count(CPU::Status status) noexcept->void {
+        if (status == CPU::Status::BAD) {
+            ++bad;
+        } else if (status == CPU::Status::HALT) {
+            ++halt;
+        } else if (status == CPU::Status::STOP) {
+            ++stop;
+        }
+    }
+
+    gb_func operator+=(Metrics const& other) noexcept->Metrics& {
+        instructions += other.instructions;
+        cycles += other.cycles;
+        bank_switches += other.bank_switches;
+        vram_writes += other.vram_writes;
+        io_reads += other.io_reads;
+        io_writes += other.io_writes;
+        bad += other.bad;
+        halt += other.halt;
+        stop += other.stop;
+        idle_cycles += other.idle_cycles;
+        return *this;
+    }
+
+    /// Counters of mem with its clock filled in, call from the thread running it
+    static auto snapshot(CPU::MCB1 const& mem) noexcept -> Metrics;
+
+    /// Title from the cartridge header, printable ASCII only, for the rom label of the exports
+    static auto title(CPU::MCB1 const& mem) -> std::string;
+
+    /// Prometheus text exposition format, every sample labelled with rom
+    auto prometheus(std::string_view rom) const -> std::string;
+
+    auto json(std::string_view rom) const -> std::string;
+};
@@ -0,0 +1,73 @@
+#include "png.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+
+using namespace gb;
+
+namespace {
+    auto put32(std::vector<byte_t>& out, std::uint32_t value) -> void {
+        for (auto shift = 24; shift >= 0; shift -= 8) {
+            out.push_back(static_cast<byte_t>(value >> shift));
+        }
+    }
+
+    /// Length, type, data and a CRC over type and data
+    auto chunk(std::vector<byte_t>& out, char const (&type)[5], std::vector<byte_t> const& data) -> void {
+        put32(out, static_cast<std::uint32_t>(data.size()));
+        auto const start = out.size();
+        out.insert(out.end(), type, type + 4);
+        out.insert(out.end(), data.begin(), data.end());
+        put32(out, PNG::crc32(out.data() + start, out.size() - start));
+    }
+}
+
+auto PNG::encode(byte_t const* rgba, std::size_t width, std::size_t height) -> std::vector<byte_t> {
+    // Scanlines with filter type 0 in front of each
+    auto const stride = width * 4;
+    auto raw = std::vector<byte_t>{};
+    raw.reserve((stride + 1) * height);
+    for (auto y = std::size_t{}; y != height; ++y) {
+        raw.push_back(0);
+        raw.insert(raw.end(), rgba + y * stride, rgba + (y + 1) * stride);
+    }
+
+    // zlib stream of stored blocks, each at most 65535 bytes
+    constexpr std::size_t block = 0xFFFF;
+    auto zlib = std::vector<byte_t>{0x78, 0x01};
+    zlib.reserve(raw.size() + raw.size() / block * 5 + 16);
+    for (auto offset = std::size_t{};;) {
+        auto const size = std::min(block, raw.size() - offset);
+        auto const last = offset + size == raw.size();
+        zlib.push_back(last);
+        zlib.push_back(static_cast<byte_t>(size));
+        zlib.push_back(static_cast<byte_t>(size >> 8));
+        zlib.push_back(static_cast<byte_t>(~size));
+        zlib.push_back(static_cast<byte_t>(~size >> 8));
+        zlib.insert(zlib.end(), raw.begin() + static_cast<std::ptrdiff_t>(offset),
+                    raw.begin() + static_cast<std::ptrdiff_t>(offset + size));
+        offset += size;
+        if (last) {
+            break;
+        }
+    }
+    put32(zlib, adler32(raw.data(), raw.size()));
+
+    auto header = std::vector<byte_t>{};
+    put32(header, static_cast<std::uint32_t>(width));
+    put32(header, static_cast<std::uint32_t>(height));
+    header.insert(header.end(), {8, 6, 0, 0, 0});
+
+    auto out = std::vector<byte_t>{0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    chunk(out, "IHDR", header);
+    chunk(out, "IDAT", zlib);
+    chunk(out, "IEND", {});
+    return out;
+}
+
+auto PNG::write(char const* filename, byte_t const* rgba, std::size_t width, std::size_t height) -> bool {
+    auto const data = encode(rgba, width, height);
+    auto const file = std::unique_ptr<FILE, decltype(&fclose)>(fopen(filename, "wb"), &fclose);
+    return file && fwrite(data.data(), 1, data.size(), file.get()) == data.size();
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <vector>
+
+#include "common.hpp"
+
+/// Minimal PNG encoder for screenshots.
+/// 8 bit RGBA written as stored deflate blocks, no compression and no dependencies. Files come out about as large as
+/// the raw pixels, which is fine for a 160 x 144 screen.
+struct gb::PNG final {
+    /// rgba holds width * height * 4 bytes, rows top to bottom
+    static auto encode(byte_t const* rgba, std::size_t width, std::size_t height) -> std::vector<byte_t>;
+
+    static auto write(char const* filename, byte_t const* rgba, std::size_t width, std::size_t height) -> bool;
+
+    gb_func static crc32(byte_t const* data, std::size_t size, std::uint32_t crc = 0) noexcept->std::uint32_t {
+        crc = ~crc;
+        for (auto i = std::size_t{}; i != size; ++i) {
+            crc = crc_table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+        }
+        return ~crc;
+    }
+
+    gb_func static adler32(byte_t const* data, std::size_t size, std::uint32_t adler = 1) noexcept->std::uint32_t {
+        auto a = adler & 0xFFFF, b = adler >> 16;
+        for (auto i = std::size_t{}; i != size; ++i) {
+            a = (a + data[i]) % 65521;
+            b = (b + a) % 65521;
+        }
+        return b << 16 | a;
+    }
+
+    static constexpr auto crc_table = [] {
+        auto table = std::array<std::uint32_t, 256>{};
+        for (auto n = 0u; n != 256; ++n) {
+            auto c = n;
+            for (auto k = 0; k != 8; ++k) {
+                c = c & 1 ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+            }
+            table[n] = c;
+        }
+        return table;
+    }();
+};
@@ -0,0 +1,447 @@
+#include "ppu.hpp"
+
+#include <algorithm>
+
+using namespace gb;
+
+namespace {
+    constexpr std::uint32_t dmg_shades[4] = {0xFFFFFFFF, 0xFFAAAAAA, 0xFF555555, 0xFF000000};
+
+    gb_func dmg_color(byte_t palette, int index) noexcept->std::uint32_t { return dmg_shades[(palette >> (index * 2)) & 3]; }
+
+    gb_func tile_pixel(byte_t lo, byte_t hi, int shift) noexcept->byte_t {
+        return static_cast<byte_t>(((lo >> shift) & 1) | (((hi >> shift) & 1) << 1));
+    }
+
+    gb_func reverse(byte_t value) noexcept->byte_t {
+        value = static_cast<byte_t>((value & 0xF0) >> 4 | (value & 0x0F) << 4);
+        value = static_cast<byte_t>((value & 0xCC) >> 2 | (value & 0x33) << 2);
+        return static_cast<byte_t>((value & 0xAA) >> 1 | (value & 0x55) << 1);
+    }
+
+    auto palette_write(byte_t& index, std::array<byte_t, 64>& ram, std::array<std::uint32_t, 32>& rgb, byte_t value)
+        -> void {
+        auto const i = index & 0x3F;
+        ram[i] = value;
+        rgb[i >> 1] = PPU::rgb555(ram[i & ~1], ram[i | 1]);
+        if (index & 0x80) {
+            index = static_cast<byte_t>(0x80 | ((i + 1) & 0x3F));
+        }
+    }
+}
+
+PPU::PPU() noexcept {
+    // CGB boot leaves palettes white
+    bg_palette.fill(0xFF);
+    obj_palette.fill(0xFF);
+    bg_rgb.fill(rgb555(0xFF, 0xFF));
+    obj_rgb.fill(rgb555(0xFF, 0xFF));
+}
+
+auto PPU::rgb555(byte_t lo, byte_t hi) noexcept -> std::uint32_t {
+    auto const color = word_pack(lo, hi);
+    auto const expand = [](unsigned c) { return (c << 3) | (c >> 2); };
+    auto const r = expand(color & 0x1F);
+    auto const g = expand((color >> 5) & 0x1F);
+    auto const b = expand((color >> 10) & 0x1F);
+    return 0xFF000000 | (r << 16) | (g << 8) | b;
+}
+
+auto PPU::read(std::uint64_t cycles, word_t address) const noexcept -> byte_t {
+    auto const position = static_cast<std::uint32_t>(cycles % frame_cycles);
+    auto const lcd_on = (lcdc & 0x80) != 0;
+    auto const ly = lcd_on ? position / line_cycles : 0;
+    switch (address) {
+        case 0xFF40:
+            return lcdc;
+        case 0xFF41: {
+            auto const dot = position % line_cycles;
+            auto mode = 0;
+            if (!lcd_on) {
+                mode = 0;
+            } else if (ly >= height) {
+                mode = 1;
+            } else if (dot < oam_dot) {
+                mode = 2;
+            } else if (dot < hblank_dot) {
+                mode = 3;
+            }
+            return static_cast<byte_t>(0x80 | (stat & 0x78) | ((ly == lyc) << 2) | mode);
+        }
+        case 0xFF42:
+            return scy;
+        case 0xFF43:
+            return scx;
+        case 0xFF44:
+            return static_cast<byte_t>(ly);
+        case 0xFF45:
+            return lyc;
+        case 0xFF47:
+            return bgp;
+        case 0xFF48:
+            return obp0;
+        case 0xFF49:
+            return obp1;
+        case 0xFF4A:
+            return wy;
+        case 0xFF4B:
+            return wx;
+        case 0xFF68:
+            return cgb ? static_cast<byte_t>(bcps | 0x40) : 0xFF;
+        case 0xFF69:
+            return cgb ? bg_palette[bcps & 0x3F] : 0xFF;
+        case 0xFF6A:
+            return cgb ? static_cast<byte_t>(ocps | 0x40) : 0xFF;
+        case 0xFF6B:
+            return cgb ? obj_palette[ocps & 0x3F] : 0xFF;
+    }
+    return 0xFF;
+}
+
+auto PPU::write(word_t address, byte_t value) noexcept -> void {
+    switch (address) {
+        case 0xFF40:
+            lcdc = value;
+            break;
+        case 0xFF41:
+            stat = value & 0x78;
+            break;
+        case 0xFF42:
+            scy = value;
+            break;
+        case 0xFF43:
+            scx = value;
+            break;
+        case 0xFF45:
+            lyc = value;
+            break;
+        case 0xFF47:
+            bgp = value;
+            break;
+        case 0xFF48:
+            obp0 = value;
+            break;
+        case 0xFF49:
+            obp1 = value;
+            break;
+        case 0xFF4A:
+            wy = value;
+            break;
+        case 0xFF4B:
+            wx = value;
+            break;
+        case 0xFF68:
+            bcps = value & 0xBF;
+            break;
+        case 0xFF69:
+            if (cgb) {
+                palette_write(bcps, bg_palette, bg_rgb, value);
+            }
+            break;
+        case 0xFF6A:
+            ocps = value & 0xBF;
+            break;
+        case 0xFF6B:
+            if (cgb) {
+                palette_write(ocps, obj_palette, obj_rgb, value);
+            }
+            break;
+    }
+}
+
+auto PPU::set_renderer(Renderer value) noexcept -> void {
+    if (value == renderer) {
+        return;
+    }
+    renderer = value;
+    fifo = {};
+    line_next = frame_base + line * line_cycles + (renderer == Renderer::FIFO ? oam_dot + 1 : hblank_dot);
+}
+
+auto PPU::next_line() noexcept -> void {
+    if (++line == height) {
+        line = 0;
+        frame_base += frame_cycles;
+        window_line = 0;
+        ++frame_count;
+    }
+}
+
+auto PPU::run_lines(std::uint64_t cycles, byte_t const* vram, byte_t const* oam) noexcept -> void {
+    if (renderer == Renderer::FIFO) {
+        return run_dots(cycles, vram, oam);
+    }
+    while (line_next <= cycles) {
+        if (lcdc & 0x80) {
+            render_line(line, vram, oam);
+        } else {
+            std::fill_n(&framebuffer[line * width], width, dmg_shades[0]);
+        }
+        next_line();
+        line_next = frame_base + line * line_cycles + hblank_dot;
+    }
+}
+
+auto PPU::render_line(std::uint32_t ly, byte_t const* vram, byte_t const* oam) noexcept -> void {
+    auto const out = &framebuffer[ly * width];
+    // Background color index and CGB priority attribute per pixel, needed for sprite priority
+    auto bg_index = std::array<byte_t, width>{};
+    auto bg_priority = std::array<byte_t, width>{};
+
+    auto const draw_tiles = [&](int x, word_t map, int src_x, int src_y) {
+        auto const tile_data_unsigned = (lcdc & 0x10) != 0;
+        while (x < width) {
+            auto const map_address = map + ((src_y >> 3) & 31) * 32 + ((src_x >> 3) & 31);
+            auto const tile = vram[map_address];
+            auto const attr = cgb ? vram[0x2000 + map_address] : byte_t{};
+            auto const row = (attr & 0x40) ? 7 - (src_y & 7) : (src_y & 7);
+            auto const tile_address = tile_data_unsigned ? tile * 16 : 0x1000 + static_cast<sbyte_t>(tile) * 16;
+            auto const bank = (attr & 0x08) ? 0x2000 : 0;
+            auto const lo = vram[bank + tile_address + row * 2];
+            auto const hi = vram[bank + tile_address + row * 2 + 1];
+            for (auto bit = src_x & 7; bit < 8 && x < width; ++bit, ++x, ++src_x) {
+                auto const index = tile_pixel(lo, hi, (attr & 0x20) ? bit : 7 - bit);
+                bg_index[x] = index;
+                bg_priority[x] = attr & 0x80;
+                out[x] = cgb ? bg_rgb[(attr & 7) * 4 + index] : dmg_color(bgp, index);
+            }
+        }
+    };
+
+    if (cgb || (lcdc & 0x01)) {
+        auto const window = (lcdc & 0x20) && wy <= ly && wx < 167;
+        auto const window_x = window ? std::max(wx - 7, 0) : width;
+        if (window_x > 0) {
+            draw_tiles(0, (lcdc & 0x08) ? 0x1C00 : 0x1800, scx, (scy + ly) & 0xFF);
+        }
+        if (window) {
+            draw_tiles(window_x, (lcdc & 0x40) ? 0x1C00 : 0x1800, window_x - (wx - 7), window_line);
+            ++window_line;
+        }
+    } else {
+        std::fill_n(out, width, dmg_color(bgp, 0));
+    }
+
+    if (!(lcdc & 0x02)) {
+        return;
+    }
+    auto const sprite_height = (lcdc & 0x04) ? 16 : 8;
+    auto sprites = std::array<byte_t, 10>{};
+    auto count = 0;
+    for (int i = 0; i != 40 && count != 10; ++i) {
+        auto const row = static_cast<int>(ly) - (oam[i * 4] - 16);
+        if (row >= 0 && row < sprite_height) {
+            sprites[count++] = static_cast<byte_t>(i);
+        }
+    }
+    if (!cgb) {
+        // Lower X wins on DMG, OAM order breaks ties
+        std::stable_sort(sprites.begin(), sprites.begin() + count, [&](byte_t a, byte_t b) {
+            return oam[a * 4 + 1] < oam[b * 4 + 1];
+        });
+    }
+    // Lowest priority first so the winner is drawn last
+    for (auto i = count; i-- != 0;) {
+        auto const sprite = oam + sprites[i] * 4;
+        auto const attr = sprite[3];
+        auto row = static_cast<int>(ly) - (sprite[0] - 16);
+        if (attr & 0x40) {
+            row = sprite_height - 1 - row;
+        }
+        auto const tile = sprite_height == 16 ? (sprite[2] & 0xFE) : sprite[2];
+        auto const bank = (cgb && (attr & 0x08)) ? 0x2000 : 0;
+        auto const lo = vram[bank + tile * 16 + row * 2];
+        auto const hi = vram[bank + tile * 16 + row * 2 + 1];
+        for (int px = 0; px != 8; ++px) {
+            auto const x = sprite[1] - 8 + px;
+            if (x < 0 || x >= width) {
+                continue;
+            }
+            auto const index = tile_pixel(lo, hi, (attr & 0x20) ? px : 7 - px);
+            if (index == 0) {
+                continue;
+            }
+            if (bg_index[x] != 0) {
+                auto const behind = cgb ? (lcdc & 0x01) && (bg_priority[x] || (attr & 0x80)) : (attr & 0x80) != 0;
+                if (behind) {
+                    continue;
+                }
+            }
+            out[x] = cgb ? obj_rgb[(attr & 7) * 4 + index] : dmg_color((attr & 0x10) ? obp1 : obp0, index);
+        }
+    }
+}
+
+auto PPU::run_dots(std::uint64_t cycles, byte_t const* vram, byte_t const* oam) noexcept -> void {
+    // line_next is the cycle after the next dot to render, so every sync during the drawing period lands here
+    while (line_next <= cycles) {
+        auto const start = frame_base + line * line_cycles;
+        if (!fifo.dot) {
+            if (cycles <= start + oam_dot) {
+                line_next = start + oam_dot + 1;
+                return;
+            }
+            if (!(lcdc & 0x80)) {
+                std::fill_n(&framebuffer[line * width], width, dmg_shades[0]);
+                next_line();
+                line_next = frame_base + line * line_cycles + oam_dot + 1;
+                continue;
+            }
+            fifo_begin(oam);
+        }
+        // A line whose time is up is finished whatever its length
+        auto const until = cycles - start < line_cycles ? static_cast<std::uint32_t>(cycles - start) : ~0u;
+        while (fifo.x < width && fifo.dot < until) {
+            fifo_dot(vram, oam);
+        }
+        if (fifo.x < width) {
+            line_next = start + fifo.dot + 1;
+            return;
+        }
+        window_line += fifo.window;
+        fifo.dot = 0;
+        next_line();
+        line_next = frame_base + line * line_cycles + oam_dot + 1;
+    }
+}
+
+auto PPU::fifo_begin(byte_t const* oam) noexcept -> void {
+    fifo = Fifo{.dot = oam_dot, .discard = static_cast<byte_t>(scx & 7), .fetch_first = true};
+    auto const sprite_height = (lcdc & 0x04) ? 16 : 8;
+    for (int i = 0; i != 40 && fifo.sprite_count != 10; ++i) {
+        auto const row = static_cast<int>(line) - (oam[i * 4] - 16);
+        if (row >= 0 && row < sprite_height) {
+            fifo.sprites[fifo.sprite_count++] = static_cast<byte_t>(i);
+        }
+    }
+    // Fetched as the screen position reaches them, OAM order among equal X
+    std::stable_sort(fifo.sprites.begin(), fifo.sprites.begin() + fifo.sprite_count, [&](byte_t a, byte_t b) {
+        return oam[a * 4 + 1] < oam[b * 4 + 1];
+    });
+}
+
+auto PPU::fifo_dot(byte_t const* vram, byte_t const* oam) noexcept -> void {
+    auto& f = fifo;
+    ++f.dot;
+
+    // Window takes over the fetcher once the screen position reaches WX - 7, the background FIFO is thrown away
+    if (!f.window && (lcdc & 0x20) && (cgb || (lcdc & 0x01)) && wy <= line && wx < 167 && f.x == std::max(wx - 7, 0)) {
+        f.window = true;
+        f.fetch_step = 0;
+        f.fetch_x = 0;
+        f.bg_count = 0;
+        f.discard = static_cast<byte_t>(wx < 7 ? 7 - wx : 0);
+    }
+
+    auto const fetch = [&] {
+        auto const map = f.window ? ((lcdc & 0x40) ? 0x1C00 : 0x1800) : ((lcdc & 0x08) ? 0x1C00 : 0x1800);
+        auto const src_x = f.window ? f.fetch_x : (scx >> 3) + f.fetch_x;
+        auto const src_y = f.window ? window_line : (scy + line) & 0xFF;
+        auto const map_address = map + ((src_y >> 3) & 31) * 32 + (src_x & 31);
+        auto const row = (f.fetch_attr & 0x40) ? 7 - (src_y & 7) : (src_y & 7);
+        auto const tile_address = (lcdc & 0x10) ? f.fetch_tile * 16 : 0x1000 + static_cast<sbyte_t>(f.fetch_tile) * 16;
+        auto const data = ((f.fetch_attr & 0x08) ? 0x2000 : 0) + tile_address + row * 2;
+        switch (f.fetch_step) {
+            case 1:
+                f.fetch_tile = vram[map_address];
+                f.fetch_attr = cgb ? vram[0x2000 + map_address] : byte_t{};
+                break;
+            case 3:
+                f.fetch_lo = vram[data];
+                break;
+            case 5:
+                f.fetch_hi = vram[data + 1];
+                break;
+            case 6:
+                if (f.bg_count) {
+                    return;
+                }
+                if (f.fetch_first) {
+                    f.fetch_first = false;
+                } else {
+                    auto const flip = (f.fetch_attr & 0x20) != 0;
+                    f.bg_lo = flip ? reverse(f.fetch_lo) : f.fetch_lo;
+                    f.bg_hi = flip ? reverse(f.fetch_hi) : f.fetch_hi;
+                    f.bg_attr = f.fetch_attr;
+                    f.bg_count = 8;
+                    ++f.fetch_x;
+                }
+                f.fetch_step = 0;
+                return;
+        }
+        ++f.fetch_step;
+    };
+
+    // Sprite reached, the background fetcher finishes its row before the sprite row is fetched and merged
+    if (!f.discard && (lcdc & 0x02) && f.sprite_next != f.sprite_count) {
+        auto const sprite = oam + f.sprites[f.sprite_next] * 4;
+        if (sprite[1] == 0) {
+            ++f.sprite_next;
+        } else if (sprite[1] - 8 <= f.x) {
+            if (f.fetch_step != 6 || !f.bg_count) {
+                fetch();
+                return;
+            }
+            if (++f.sprite_wait != 6) {
+                return;
+            }
+            f.sprite_wait = 0;
+            auto const index = f.sprites[f.sprite_next++];
+            auto const attr = sprite[3];
+            auto const sprite_height = (lcdc & 0x04) ? 16 : 8;
+            auto row = static_cast<int>(line) - (sprite[0] - 16);
+            if (attr & 0x40) {
+                row = sprite_height - 1 - row;
+            }
+            auto const tile = sprite_height == 16 ? (sprite[2] & 0xFE) : sprite[2];
+            auto const bank = (cgb && (attr & 0x08)) ? 0x2000 : 0;
+            auto const lo = vram[bank + tile * 16 + (row & 15) * 2];
+            auto const hi = vram[bank + tile * 16 + (row & 15) * 2 + 1];
+            // Pixels already left of the screen are skipped, earlier sprites keep their pixels on DMG and lower
+            // OAM indices win on CGB
+            for (auto px = f.x - (sprite[1] - 8); px < 8; ++px) {
+                auto const slot = px - (f.x - (sprite[1] - 8));
+                auto const color = tile_pixel(lo, hi, (attr & 0x20) ? px : 7 - px);
+                if (color && (!f.obj_color[slot] || (cgb && index < f.obj_oam[slot]))) {
+                    f.obj_color[slot] = color;
+                    f.obj_attr[slot] = attr;
+                    f.obj_oam[slot] = index;
+                }
+            }
+            return;
+        }
+    }
+
+    fetch();
+    if (!f.bg_count) {
+        return;
+    }
+    auto bg = tile_pixel(f.bg_lo, f.bg_hi, 7);
+    auto const bg_attr = f.bg_attr;
+    f.bg_lo = static_cast<byte_t>(f.bg_lo << 1);
+    f.bg_hi = static_cast<byte_t>(f.bg_hi << 1);
+    --f.bg_count;
+    if (f.discard) {
+        --f.discard;
+        return;
+    }
+    auto const obj = f.obj_color[0];
+    auto const obj_attr = f.obj_attr[0];
+    std::copy(f.obj_color.begin() + 1, f.obj_color.end(), f.obj_color.begin());
+    std::copy(f.obj_attr.begin() + 1, f.obj_attr.end(), f.obj_attr.begin());
+    std::copy(f.obj_oam.begin() + 1, f.obj_oam.end(), f.obj_oam.begin());
+    f.obj_color[7] = 0;
+
+    // Palettes and the enable bits count at the moment the pixel leaves the FIFO
+    if (!cgb && !(lcdc & 0x01)) {
+        bg = 0;
+    }
+    auto color = cgb ? bg_rgb[(bg_attr & 7) * 4 + bg] : dmg_color(bgp, bg);
+    if (obj && (lcdc & 0x02)) {
+        auto const behind = bg && (cgb ? (lcdc & 0x01) && ((bg_attr & 0x80) || (obj_attr & 0x80)) : (obj_attr & 0x80));
+        if (!behind) {
+            color = cgb ? obj_rgb[(obj_attr & 7) * 4 + obj] : dmg_color((obj_attr & 0x10) ? obp1 : obp0, obj);
+        }
+    }
+    framebuffer[line * width + f.x++] = color;
+}
@@ -0,0 +1,122 @@
+#pragma once
+#include "common.hpp"
+
+/// Pixel processing unit.
+/// The scanline renderer draws lines whole once the frame position passes their drawing period, every register, VRAM
+/// or OAM write first catches rendering up to the current cycle so changes between lines land on the right line. The
+/// pixel FIFO renderer steps the background fetcher, sprite fetches and both FIFOs dot by dot through the drawing
+/// period instead, so writes in the middle of a line take effect at the pixel they reach. STAT and the interrupt
+/// timing keep the fixed line layout with either one.
+struct gb::PPU final {
+    static constexpr int width = 160;
+    static constexpr int height = 144;
+    static constexpr std::uint32_t line_cycles = 456;
+    static constexpr std::uint32_t oam_dot = 80;
+    static constexpr std::uint32_t hblank_dot = 252;
+    static constexpr std::uint32_t lines = frame_cycles / line_cycles;
+
+    using Frame = std::array<std::uint32_t, width * height>;
+
+    enum class Renderer : byte_t { SCANLINE, FIFO };
+
+    /// Progress of the pixel FIFO renderer through the current line, dot 0 until its drawing period has started
+    struct Fifo {
+        std::uint32_t dot = {};
+        int x = {};
+        /// Pixels still dropped from the front, SCX fine scroll or the part of the window left of the screen
+        byte_t discard = {};
+        bool window = {};
+
+        /// Background fetcher, two dots per step and a push that waits for an empty FIFO. The first row of a line is
+        /// fetched twice.
+        byte_t fetch_step = {};
+        byte_t fetch_x = {};
+        bool fetch_first = {};
+        byte_t fetch_tile = {};
+        byte_t fetch_attr = {};
+        byte_t fetch_lo = {};
+        byte_t fetch_hi = {};
+
+        /// Background FIFO, one tile row shifted out from the top bit
+        byte_t bg_lo = {};
+        byte_t bg_hi = {};
+        byte_t bg_attr = {};
+        byte_t bg_count = {};
+
+        /// Sprites of the line in fetch order, the one being fetched holds pixel output for six dots
+        std::array<byte_t, 10> sprites = {};
+        byte_t sprite_count = {};
+        byte_t sprite_next = {};
+        byte_t sprite_wait = {};
+
+        /// Object FIFO, color 0 is transparent
+        std::array<byte_t, 8> obj_color = {};
+        std::array<byte_t, 8> obj_attr = {};
+        std::array<byte_t, 8> obj_oam = {};
+    };
+
+    Renderer renderer = Renderer::SCANLINE;
+    bool cgb = {};
+    byte_t lcdc = 0x91;
+    byte_t stat = {};
+    byte_t scy = {};
+    byte_t scx = {};
+    byte_t lyc = {};
+    byte_t bgp = 0xFC;
+    byte_t obp0 = 0xFF;
+    byte_t obp1 = 0xFF;
+    byte_t wy = {};
+    byte_t wx = {};
+    byte_t window_line = {};
+
+    /// CGB palette RAM, converted colors are kept next to it so rendering never decodes RGB555
+    byte_t bcps = {};
+    byte_t ocps = {};
+    std::array<byte_t, 64> bg_palette = {};
+    std::array<byte_t, 64> obj_palette = {};
+    std::array<std::uint32_t, 32> bg_rgb = {};
+    std::array<std::uint32_t, 32> obj_rgb = {};
+
+    /// Next line to render and the cycle at which it may be rendered
+    std::uint32_t line = {};
+    std::uint64_t frame_base = {};
+    std::uint64_t line_next = hblank_dot;
+    std::uint64_t frame_count = {};
+    Fifo fifo = {};
+    Frame framebuffer = {};
+
+    PPU() noexcept;
+
+    /// Register access in 0xFF40 - 0xFF4B and 0xFF68 - 0xFF6B
+    auto read(std::uint64_t cycles, word_t address) const noexcept -> byte_t;
+
+    auto write(word_t address, byte_t value) noexcept -> void;
+
+    /// Switches renderers on a running PPU, sync first. The line in progress starts over in the new one, line_next
+    /// and fifo mean different things in each.
+    auto set_renderer(Renderer value) noexcept -> void;
+
+    /// Renders every line whose drawing period ended before cycles
+    gb_func run_until(std::uint64_t cycles, byte_t const* vram, byte_t const* oam) noexcept->void {
+        if (line_next <= cycles) [[unlikely]] {
+            run_lines(cycles, vram, oam);
+        }
+    }
+
+    auto run_lines(std::uint64_t cycles, byte_t const* vram, byte_t const* oam) noexcept -> void;
+
+    auto render_line(std::uint32_t ly, byte_t const* vram, byte_t const* oam) noexcept -> void;
+
+    /// Pixel FIFO counterpart of run_lines, renders every dot before cycles
+    auto run_dots(std::uint64_t cycles, byte_t const* vram, byte_t const* oam) noexcept -> void;
+
+    /// OAM scan and fetcher reset at the start of the drawing period
+    auto fifo_begin(byte_t const* oam) noexcept -> void;
+
+    auto fifo_dot(byte_t const* vram, byte_t const* oam) noexcept -> void;
+
+    /// Advances to the next visible line, wrapping into the next frame after the last one
+    auto next_line() noexcept -> void;
+
+    static auto rgb555(byte_t lo, byte_t hi) noexcept -> std::uint32_t;
+};
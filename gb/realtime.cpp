@@ -0,0 +1,65 @@
+#include "realtime.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+using namespace gb;
+
+auto Realtime::start() -> void {
+    stop();
+    running.store(true, std::memory_order_relaxed);
+    thread = std::thread([this] { emulate(); });
+}
+
+auto Realtime::stop() noexcept -> void {
+    running.store(false, std::memory_order_relaxed);
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+auto Realtime::emulate() noexcept -> void {
+    using clock = std::chrono::steady_clock;
+    auto const period = std::chrono::duration<double>(1.0 / frame_rate);
+    auto samples = std::vector<std::int16_t>{};
+    auto deadline = clock::now();
+    while (running.load(std::memory_order_relaxed)) {
+        auto const frame_end = mem.cycles - mem.cycles % frame_cycles + frame_cycles;
+        if (auto const result = mem.run(cpu, frame_end); result != CPU::Status::OK) {
+            status.store(result, std::memory_order_relaxed);
+            break;
+        }
+        mem.video_sync();
+        video.write_buffer() = mem.ppu.framebuffer;
+        video.publish();
+
+        mem.apu.end_frame(mem.cycles);
+        samples.resize(mem.apu.samples_avail() * 2);
+        samples.resize(mem.apu.read_samples(samples.data(), samples.size() / 2) * 2);
+        // Never split a stereo pair when the ring is full
+        auto const room = (audio_capacity - audio.size()) & ~std::size_t{1};
+        audio.push(samples.data(), std::min(samples.size(), room));
+
+        auto const count = frames.fetch_add(1, std::memory_order_release) + 1;
+        if (frame_limit >= 0 && count >= static_cast<std::uint64_t>(frame_limit)) {
+            break;
+        }
+
+        // Queue above target means emulation outpaces the audio device, so stretch the frame slightly
+        auto scale = 1.0;
+        if (audio_target) {
+            auto const fill = static_cast<double>(audio.size());
+            auto const error = (fill - audio_target) / audio_target;
+            scale += std::clamp(error * max_adjust, -max_adjust, max_adjust);
+        }
+        deadline += std::chrono::duration_cast<clock::duration>(period * scale);
+        auto const now = clock::now();
+        if (deadline + period * max_lag_frames < now) {
+            // Too far behind to catch up without a burst, start pacing from here
+            deadline = now;
+        }
+        std::this_thread::sleep_until(deadline);
+    }
+    running.store(false, std::memory_order_release);
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <atomic>
+#include <thread>
+
+#include "cpu.hpp"
+#include "mcb1.hpp"
+#include "spsc.hpp"
+#include "triple.hpp"
+
+/// Frame paced run mode.
+/// Emulation runs on its own thread and sleeps until each frame deadline, finished frames go through a triple buffer
+/// and samples through a ring so presentation and audio threads never block it. When an audio consumer drains the
+/// ring, its fill level nudges the frame period by a fraction of a percent to track the audio device clock.
+struct gb::Realtime final {
+    static constexpr double frame_rate = static_cast<double>(clock_rate) / frame_cycles;
+    static constexpr std::size_t audio_capacity = 1 << 15;
+    static constexpr double max_adjust = 0.005;
+    static constexpr int max_lag_frames = 4;
+
+    CPU& cpu;
+    CPU::MCB1& mem;
+    Triple<PPU::Frame> video = {};
+    SPSC<std::int16_t, audio_capacity> audio = {};
+    /// Desired number of queued samples (both channels), zero disables drift correction
+    std::size_t audio_target = {};
+    long long frame_limit = -1;
+    std::atomic<bool> running = {};
+    std::atomic<CPU::Status> status = CPU::Status::OK;
+    std::atomic<std::uint64_t> frames = {};
+    std::thread thread = {};
+
+    Realtime(CPU& cpu, CPU::MCB1& mem) noexcept : cpu(cpu), mem(mem) {}
+    Realtime(Realtime const&) = delete;
+    Realtime& operator=(Realtime const&) = delete;
+    ~Realtime() { stop(); }
+
+    /// Enables audio driven pacing, latency is the amount of audio kept queued ahead of the consumer
+    auto sync_audio(double latency) noexcept -> void {
+        audio_target = static_cast<std::size_t>(latency * APU::sample_rate_default) * 2;
+    }
+
+    auto start() -> void;
+
+    auto stop() noexcept -> void;
+
+    auto emulate() noexcept -> void;
+};
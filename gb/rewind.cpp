@@ -0,0 +1,152 @@
+#include "rewind.hpp"
+
+#include <algorithm>
+
+#include "kernels.hpp"
+#include "mcb1.hpp"
+#include "state.hpp"
+
+using namespace gb;
+
+Rewind::Rewind(std::size_t state_size, std::size_t frames, std::size_t budget)
+    : state_size(state_size), max_frames(std::max<std::size_t>(frames, 1)), budget(budget) {
+    for (auto i = std::size_t{}; i != slot_count; ++i) {
+        slots.push_back(std::make_unique_for_overwrite<byte_t[]>(state_size));
+        free.push(i);
+    }
+    head = std::make_unique_for_overwrite<byte_t[]>(state_size);
+    delta = std::make_unique_for_overwrite<byte_t[]>(state_size);
+    // Left uninitialized so pages are only committed once deltas reach them
+    ring = std::make_unique_for_overwrite<byte_t[]>(budget);
+    entries.resize(max_frames);
+    thread = std::thread([this] { worker(); });
+}
+
+Rewind::~Rewind() {
+    running.store(false, std::memory_order_release);
+    signal.fetch_add(1, std::memory_order_release);
+    signal.notify_one();
+    thread.join();
+}
+
+auto Rewind::capture(CPU const& cpu, CPU::MCB1 const& mem) noexcept -> bool {
+    ++captured;
+    auto index = std::size_t{};
+    if (!free.pop(index)) {
+        ++dropped;
+        return false;
+    }
+    State::save(cpu, mem, slots[index].get(), state_size);
+    in_flight.fetch_add(1, std::memory_order_relaxed);
+    queued.push(index);
+    signal.fetch_add(1, std::memory_order_release);
+    signal.notify_one();
+    return true;
+}
+
+auto Rewind::rewind(CPU& cpu, CPU::MCB1& mem, std::size_t frames) noexcept -> long long {
+    drain();
+    auto const lock = std::lock_guard(mutex);
+    if (!has_head) {
+        return -1;
+    }
+    auto const& kernels = Kernels::best();
+    auto const steps = std::min(frames, count);
+    for (auto step = std::size_t{}; step != steps; ++step) {
+        auto const newest = entries[(first + count - 1) % max_frames];
+        if (newest.size) {
+            LZ::decompress(ring.get() + newest.offset, newest.size, delta.get(), state_size);
+            kernels.xor_delta(head.get(), head.get(), delta.get(), state_size);
+        }
+        --count;
+        bytes -= newest.size;
+        write = newest.offset;
+    }
+    State::load(cpu, mem, head.get(), state_size);
+    return static_cast<long long>(steps);
+}
+
+auto Rewind::drain() noexcept -> void {
+    for (auto value = in_flight.load(std::memory_order_acquire); value; value = in_flight.load()) {
+        in_flight.wait(value, std::memory_order_acquire);
+    }
+}
+
+auto Rewind::stats() noexcept -> Stats {
+    drain();
+    auto const lock = std::lock_guard(mutex);
+    return {count, bytes, captured, dropped};
+}
+
+auto Rewind::worker() noexcept -> void {
+    while (true) {
+        auto const seen = signal.load(std::memory_order_acquire);
+        auto index = std::size_t{};
+        if (queued.pop(index)) {
+            {
+                auto const lock = std::lock_guard(mutex);
+                store(index);
+            }
+            free.push(index);
+            in_flight.fetch_sub(1, std::memory_order_release);
+            in_flight.notify_all();
+            continue;
+        }
+        if (!running.load(std::memory_order_acquire)) {
+            return;
+        }
+        signal.wait(seen, std::memory_order_acquire);
+    }
+}
+
+auto Rewind::store(std::size_t index) noexcept -> void {
+    auto& state = slots[index];
+    if (has_head) {
+        if (!Kernels::best().xor_delta(delta.get(), state.get(), head.get(), state_size)) {
+            push_entry({write, 0});
+        } else if (auto const out = reserve(LZ::bound(state_size))) {
+            auto const size = lz.compress(delta.get(), state_size, out);
+            push_entry({write, size});
+            write += size;
+            bytes += size;
+        }
+    }
+    // Old head buffer goes back to the pool with this slot
+    std::swap(state, head);
+    has_head = true;
+}
+
+auto Rewind::push_entry(Entry entry) noexcept -> void {
+    if (count == max_frames) {
+        pop_oldest();
+    }
+    entries[(first + count) % max_frames] = entry;
+    ++count;
+}
+
+auto Rewind::reserve(std::size_t size) noexcept -> byte_t* {
+    if (size > budget) {
+        // History can not hold a single delta, keep only the head
+        count = 0;
+        bytes = 0;
+        write = 0;
+        return nullptr;
+    }
+    if (write + size > budget) {
+        // Everything between write and the end is older than what sits at the start
+        while (count && entries[first].offset >= write) {
+            pop_oldest();
+        }
+        write = 0;
+    }
+    while (count && entries[first].offset < write + size && entries[first].offset + entries[first].size > write) {
+        pop_oldest();
+    }
+    return ring.get() + write;
+}
+
+auto Rewind::pop_oldest() noexcept -> void {
+    bytes -= entries[first].size;
+    first = (first + 1) % max_frames;
+    --count;
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "cpu.hpp"
+#include "lz.hpp"
+#include "spsc.hpp"
+
+/// Rewind history of recent machine states.
+/// Capturing only copies a State snapshot into a free slot and hands it to a worker thread. The worker keeps the
+/// newest snapshot in full and stores every older one as the compressed XOR against its successor, so stepping back
+/// is a decompress and an XOR and the oldest deltas can be dropped at any time. Deltas live in one ring of budget
+/// bytes, once it is full the oldest ones go. When the worker falls behind, captures are dropped instead of
+/// waiting, the next delta then simply spans more frames.
+struct gb::Rewind final {
+    static constexpr std::size_t slot_count = 8;
+
+    struct Entry {
+        std::size_t offset = {};
+        std::size_t size = {};
+    };
+
+    struct Stats {
+        std::size_t frames = {};
+        std::size_t bytes = {};
+        std::uint64_t captured = {};
+        std::uint64_t dropped = {};
+    };
+
+    std::size_t const state_size;
+    std::size_t const max_frames;
+    std::size_t const budget;
+
+    /// Snapshot slots, owned by the emulation thread while free and by the worker while queued
+    std::vector<std::unique_ptr<byte_t[]>> slots = {};
+    SPSC<std::size_t, slot_count> queued = {};
+    SPSC<std::size_t, slot_count> free = {};
+    std::atomic<std::size_t> in_flight = {};
+    std::atomic<std::uint64_t> signal = {};
+    std::atomic<bool> running = true;
+    std::uint64_t captured = {};
+    std::uint64_t dropped = {};
+
+    /// History, guarded by mutex
+    std::mutex mutex = {};
+    std::unique_ptr<byte_t[]> head = {};
+    bool has_head = {};
+    std::unique_ptr<byte_t[]> delta = {};
+    std::unique_ptr<byte_t[]> ring = {};
+    std::vector<Entry> entries = {};
+    std::size_t first = {};
+    std::size_t count = {};
+    std::size_t write = {};
+    std::size_t bytes = {};
+    LZ lz = {};
+    std::thread thread = {};
+
+    /// frames is the history length, budget the bytes compressed deltas may take
+    Rewind(std::size_t state_size, std::size_t frames, std::size_t budget);
+    Rewind(Rewind const&) = delete;
+    Rewind& operator=(Rewind const&) = delete;
+    ~Rewind();
+
+    /// Emulation thread, returns false if the snapshot was dropped because the worker is behind
+    auto capture(CPU const& cpu, CPU::MCB1 const& mem) noexcept -> bool;
+
+    /// Emulation thread, loads the state frames captures back, 0 is the newest, returns how far it went or -1 if
+    /// nothing was captured yet. History newer than the loaded state is discarded.
+    auto rewind(CPU& cpu, CPU::MCB1& mem, std::size_t frames) noexcept -> long long;
+
+    /// Waits until every capture so far is in the history
+    auto drain() noexcept -> void;
+
+    /// Emulation thread, includes every capture so far
+    auto stats() noexcept -> Stats;
+
+    /// Worker thread
+    auto worker() noexcept -> void;
+
+    /// Makes the snapshot in slots[index] the new head, the old head becomes the newest delta
+    auto store(std::size_t index) noexcept -> void;
+
+    auto push_entry(Entry entry) noexcept -> void;
+
+    /// Makes room for size bytes at the write position, dropping the oldest deltas in the way
+    auto reserve(std::size_t size) noexcept -> byte_t*;
+
+    auto pop_oldest() noexcept -> void;
+};
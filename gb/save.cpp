@@ -0,0 +1,130 @@
+#include "save.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include "mcb1.hpp"
+
+using namespace gb;
+
+auto Save::open(char const* filename, std::size_t requested_size) -> bool {
+    close();
+    size = std::clamp<std::size_t>(requested_size, 0x2000, max_size);
+    fd = ::open(filename, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info = {};
+    if (::fstat(fd, &info) != 0 || (static_cast<std::size_t>(info.st_size) < size && ::ftruncate(fd, size) != 0)) {
+        ::close(fd);
+        fd = -1;
+        return false;
+    }
+    auto const map = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    mapped = map != MAP_FAILED;
+    if (mapped) {
+        data = static_cast<byte_t*>(map);
+    } else {
+        data = mem.ERAM.data();
+        if (::pread(fd, data, size, 0) < 0) {
+            ::close(fd);
+            fd = -1;
+            return false;
+        }
+    }
+    for (auto& word : dirty) {
+        word.store(0, std::memory_order_relaxed);
+    }
+    mem.eram_data = data;
+    mem.eram_size = size;
+    mem.save = this;
+    mem.remap();
+    requested.store(false, std::memory_order_relaxed);
+    running.store(true, std::memory_order_relaxed);
+    thread = std::thread([this] { worker(); });
+    return true;
+}
+
+auto Save::close() noexcept -> void {
+    if (thread.joinable()) {
+        {
+            auto const lock = std::lock_guard(mutex);
+            running.store(false, std::memory_order_relaxed);
+        }
+        wake.notify_one();
+        thread.join();
+    }
+    if (fd < 0) {
+        return;
+    }
+    flush(true);
+    if (mapped) {
+        std::memcpy(mem.ERAM.data(), data, size);
+        ::munmap(data, size);
+    }
+    ::close(fd);
+    fd = -1;
+    data = {};
+    mapped = {};
+    mem.eram_data = mem.ERAM.data();
+    mem.eram_size = mem.ERAM.size();
+    mem.save = nullptr;
+    mem.remap();
+}
+
+auto Save::flush(bool all) noexcept -> std::size_t {
+    auto count = std::size_t{};
+    auto first = size;
+    auto last = std::size_t{};
+    for (auto i = std::size_t{}; i != std::size(dirty); ++i) {
+        auto bits = dirty[i].exchange(0, std::memory_order_acquire);
+        if (all) {
+            bits = ~std::uint64_t{};
+        }
+        for (; bits; bits &= bits - 1) {
+            auto const offset = (i * 64 + static_cast<std::size_t>(__builtin_ctzll(bits))) * page_size;
+            if (offset >= size) {
+                break;
+            }
+            ++count;
+            first = std::min(first, offset);
+            last = std::max(last, offset + page_size);
+            if (!mapped) {
+                // Racing with the emulation thread is fine, a page written meanwhile is marked again
+                ::pwrite(fd, data + offset, page_size, static_cast<off_t>(offset));
+            }
+        }
+    }
+    if (!count) {
+        return 0;
+    }
+    if (mapped) {
+        // msync wants a host page aligned start, the mapping itself starts on one
+        auto const host_page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+        first -= first % host_page;
+        ::msync(data + first, last - first, MS_SYNC);
+    } else {
+        ::fdatasync(fd);
+    }
+    pages_written.fetch_add(count, std::memory_order_relaxed);
+    return count;
+}
+
+auto Save::worker() noexcept -> void {
+    auto lock = std::unique_lock(mutex);
+    while (running.load(std::memory_order_relaxed)) {
+        // request() does not take the mutex, a wakeup lost to that race only delays the flush to the next interval
+        wake.wait_for(lock, interval, [this] {
+            return requested.load(std::memory_order_acquire) || !running.load(std::memory_order_relaxed);
+        });
+        requested.store(false, std::memory_order_relaxed);
+        lock.unlock();
+        flush();
+        lock.lock();
+    }
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "cpu.hpp"
+#include "header.hpp"
+
+/// Battery backed cartridge RAM kept in a .sav file.
+/// The file is mapped with MAP_SHARED and becomes ERAM itself, so a write is in the page cache the moment the CPU makes
+/// it. Writes mark their 256 byte page dirty, a background thread syncs dirty pages every interval or as soon as the
+/// game disables RAM. When the file can not be mapped ERAM stays in memory and dirty pages are written with pwrite.
+struct gb::Save final {
+    static constexpr std::size_t page_size = 0x100;
+    static constexpr std::size_t max_size = 0x8000;
+
+    CPU::MCB1& mem;
+    byte_t* data = {};
+    std::size_t size = {};
+    int fd = -1;
+    bool mapped = {};
+
+    /// One bit per page, set by the emulation thread and taken by the flush thread
+    std::atomic<std::uint64_t> dirty[max_size / page_size / 64] = {};
+    std::atomic<std::uint64_t> pages_written = {};
+
+    std::chrono::milliseconds interval = std::chrono::milliseconds{1000};
+    std::atomic<bool> requested = {};
+    std::atomic<bool> running = {};
+    std::mutex mutex = {};
+    std::condition_variable wake = {};
+    std::thread thread = {};
+
+    explicit Save(CPU::MCB1& mem) noexcept : mem(mem) {}
+    Save(Save const&) = delete;
+    Save& operator=(Save const&) = delete;
+    ~Save() { close(); }
+
+    /// RAM size the header declares, clamped to what ERAM can bank
+    gb_func static ram_size(Header const& header) noexcept->std::size_t {
+        return std::clamp(header.ram_size, std::size_t{0x2000}, max_size);
+    }
+
+    /// Opens or creates filename, grows it to size and attaches it to mem as ERAM
+    auto open(char const* filename, std::size_t size) -> bool;
+
+    /// Detaches from mem after writing everything back, ERAM keeps the contents
+    auto close() noexcept -> void;
+
+    /// Emulation thread, offset is relative to the start of ERAM
+    auto mark(std::size_t offset) noexcept -> void {
+        auto& word = dirty[offset / page_size / 64];
+        auto const bit = std::uint64_t{1} << (offset / page_size % 64);
+        // Plain load first, a locked RMW per RAM write would cost more than the write itself
+        if (!(word.load(std::memory_order_relaxed) & bit)) {
+            word.fetch_or(bit, std::memory_order_release);
+        }
+    }
+
+    /// Emulation thread, asks for a flush without waiting for it
+    auto request() noexcept -> void {
+        requested.store(true, std::memory_order_release);
+        wake.notify_one();
+    }
+
+    /// Writes dirty pages, or all of them, returns the number of pages written
+    auto flush(bool all = false) noexcept -> std::size_t;
+
+    /// Flush thread
+    auto worker() noexcept -> void;
+};
@@ -0,0 +1,147 @@
+#pragma once
+#include <functional>
+#include <string>
+#include <string_view>
+
+#include "common.hpp"
+#include "spsc.hpp"
+
+/// Serial port (0xFF01 - 0xFF02).
+/// Every byte shifted out under the internal clock is appended to a small buffer that is flushed to an optional file
+/// and callback, the last ring_size bytes also stay readable in memory. A peer is attached through a pair of
+/// channels carrying timestamped messages, so the exchange does not depend on how the two sides are scheduled.
+struct gb::Serial final {
+    struct Message {
+        std::uint64_t cycle = {};
+        std::uint32_t duration = {};  // zero for the reply of the externally clocked side
+        byte_t data = {};
+    };
+
+    using Channel = SPSC<Message, 64>;
+
+    static constexpr std::uint64_t never = ~std::uint64_t{};
+    static constexpr std::size_t ring_size = 1 << 12;
+    static constexpr std::size_t buffer_size = 1 << 12;
+
+    byte_t data = {};
+    byte_t control = {};
+    bool cgb = {};
+
+    /// Transfer in flight, completes at transfer_end with incoming shifted into data
+    std::uint64_t transfer_end = never;
+    byte_t incoming = 0xFF;
+
+    /// Link cable, both null when nothing is plugged in
+    Channel* tx = {};
+    Channel* rx = {};
+    std::size_t latched = {};
+
+    /// Output sinks, none by default so embedders and batch runs stay off stdio
+    FILE* file = {};
+    std::function<void(std::string_view)> callback = {};
+    std::string buffer = {};
+    std::array<char, ring_size> ring = {};
+    std::uint64_t ring_count = {};
+
+    Serial() = default;
+    Serial(Serial const&) = delete;
+    Serial& operator=(Serial const&) = delete;
+    ~Serial() { flush(); }
+
+    /// Base clocks for one byte, the shift clock follows the CPU clock in double speed mode
+    gb_func duration(byte_t cycle_step) const noexcept->std::uint32_t {
+        auto const bit = cgb && (control & 0x02) ? 16u : 512u;
+        return 8 * bit * cycle_step / 4;
+    }
+
+    /// Makes messages pushed by the peer so far visible to the current batch
+    auto latch() noexcept -> void { latched = rx ? rx->size() : 0; }
+
+    auto next_cycle() const noexcept -> std::uint64_t {
+        return latched ? std::min(transfer_end, rx->front().cycle) : transfer_end;
+    }
+
+    gb_func read(word_t address) const noexcept->byte_t {
+        if (address == 0xFF01) {
+            return data;
+        }
+        return static_cast<byte_t>(control | (cgb ? 0x7C : 0x7E));
+    }
+
+    /// Returns cycle of the next serial event
+    auto write(std::uint64_t cycles, word_t address, byte_t value, byte_t cycle_step) -> std::uint64_t {
+        if (address == 0xFF01) {
+            data = value;
+        } else {
+            control = value & (cgb ? 0x83 : 0x81);
+            if ((control & 0x81) == 0x81) {
+                output(static_cast<char>(data));
+                auto const length = duration(cycle_step);
+                transfer_end = cycles + length;
+                incoming = 0xFF;
+                if (tx) {
+                    tx->push(Message{cycles, length, data});
+                }
+            }
+        }
+        return next_cycle();
+    }
+
+    /// Services peer messages and transfer completion that are due, returns cycle of the next one
+    auto apply(std::uint64_t cycles) noexcept -> std::uint64_t {
+        while (latched && rx->front().cycle <= cycles) {
+            auto const message = rx->front();
+            rx->pop();
+            --latched;
+            if (message.duration) {
+                // Peer drives the clock, answer with our byte and finish together with it
+                tx->push(Message{message.cycle, 0, data});
+                incoming = message.data;
+                transfer_end = message.cycle + message.duration;
+            } else {
+                incoming = message.data;
+            }
+        }
+        if (transfer_end <= cycles) {
+            data = incoming;
+            control &= 0x7F;
+            transfer_end = never;
+            incoming = 0xFF;
+        }
+        return next_cycle();
+    }
+
+    auto output(char c) -> void {
+        ring[ring_count++ % ring_size] = c;
+        if (file || callback) {
+            buffer.push_back(c);
+            if (buffer.size() >= buffer_size) {
+                flush();
+            }
+        }
+    }
+
+    auto flush() -> void {
+        if (buffer.empty()) {
+            return;
+        }
+        if (file) {
+            fwrite(buffer.data(), 1, buffer.size(), file);
+            fflush(file);
+        }
+        if (callback) {
+            callback(buffer);
+        }
+        buffer.clear();
+    }
+
+    /// Last bytes sent, oldest first
+    auto text() const -> std::string {
+        auto const count = std::min<std::uint64_t>(ring_count, ring_size);
+        auto result = std::string{};
+        for (auto i = ring_count - count; i != ring_count; ++i) {
+            result.push_back(ring[i % ring_size]);
+        }
+        return result;
+    }
+};
@@ -0,0 +1,69 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <new>
+
+#include "common.hpp"
+
+/// Bounded single-producer single-consumer queue.
+/// Each side owns one index and only reads the other, so neither side ever waits on a lock.
+template <typename T, std::size_t N>
+struct gb::SPSC final {
+    static_assert(std::has_single_bit(N), "Capacity must be a power of two!");
+
+    static constexpr std::size_t cache_line = 64;
+
+    alignas(cache_line) std::atomic<std::size_t> head = {};
+    alignas(cache_line) std::atomic<std::size_t> tail = {};
+    alignas(cache_line) std::array<T, N> items = {};
+
+    /// Producer side
+    auto push(T const& item) noexcept -> bool {
+        auto const t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == N) {
+            return false;
+        }
+        items[t & (N - 1)] = item;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// Producer side, pushes as many items as fit and returns how many did
+    auto push(T const* source, std::size_t count) noexcept -> std::size_t {
+        auto const t = tail.load(std::memory_order_relaxed);
+        count = std::min(count, N - (t - head.load(std::memory_order_acquire)));
+        for (std::size_t i = 0; i != count; ++i) {
+            items[(t + i) & (N - 1)] = source[i];
+        }
+        tail.store(t + count, std::memory_order_release);
+        return count;
+    }
+
+    /// Consumer side
+    auto size() const noexcept -> std::size_t {
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_relaxed);
+    }
+
+    auto front() const noexcept -> T const& { return items[head.load(std::memory_order_relaxed) & (N - 1)]; }
+
+    auto pop() noexcept -> void { head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+    auto pop(T* out, std::size_t count) noexcept -> std::size_t {
+        auto const h = head.load(std::memory_order_relaxed);
+        count = std::min(count, tail.load(std::memory_order_acquire) - h);
+        for (std::size_t i = 0; i != count; ++i) {
+            out[i] = items[(h + i) & (N - 1)];
+        }
+        head.store(h + count, std::memory_order_release);
+        return count;
+    }
+
+    auto pop(T& item) noexcept -> bool {
+        if (size() == 0) {
+            return false;
+        }
+        item = front();
+        pop();
+        return true;
+    }
+};
@@ -0,0 +1,123 @@
+#include "state.hpp"
+
+#include <cstring>
+
+#include "mcb1.hpp"
+
+using namespace gb;
+
+namespace {
+    struct Prefix {
+        std::uint32_t magic = {};
+        std::uint32_t version = {};
+        std::uint32_t rom_id = {};
+        std::uint32_t eram_size = {};
+    };
+
+    struct Counter {
+        std::size_t size = {};
+
+        auto raw(void*, std::size_t count) noexcept -> void { size += count; }
+    };
+
+    struct Writer {
+        byte_t* out = {};
+
+        auto raw(void* data, std::size_t count) noexcept -> void {
+            std::memcpy(out, data, count);
+            out += count;
+        }
+    };
+
+    struct Reader {
+        byte_t const* in = {};
+
+        auto raw(void* data, std::size_t count) noexcept -> void {
+            std::memcpy(data, in, count);
+            in += count;
+        }
+    };
+
+    template <typename IO, typename... T>
+    auto fields(IO& io, T&... values) noexcept -> void {
+        static_assert((std::is_trivially_copyable_v<T> && ...));
+        (io.raw(&values, sizeof(values)), ...);
+    }
+
+    /// Single list of everything in a snapshot, shared by all three passes
+    template <typename IO>
+    auto transfer(IO& io, CPU& cpu, CPU::MCB1& mem) noexcept -> void {
+        fields(io, cpu);
+        fields(io, mem.VRAM, mem.WRAM, mem.OAM, mem.HRAM);
+        io.raw(mem.eram_data, mem.eram_size);
+        fields(io, mem.eram_enable, mem.mode, mem.rom_bank, mem.wram_bank, mem.vram_bank);
+        fields(io, mem.boot_mapped);
+        fields(io, mem.cgb, mem.double_speed, mem.speed_prepare, mem.cycle_step, mem.cycles);
+        fields(io, mem.dma_source, mem.dma_until);
+        fields(io, mem.hdma_source, mem.hdma_dest, mem.hdma_length, mem.hdma_active, mem.hdma_next);
+
+        auto& apu = mem.apu;
+        fields(io, apu.regs, apu.square1, apu.square2, apu.wave, apu.noise, apu.output);
+        fields(io, apu.power, apu.frame_step, apu.time, apu.frame_start, apu.frame_next);
+
+        auto& ppu = mem.ppu;
+        fields(io, ppu.cgb, ppu.lcdc, ppu.stat, ppu.scy, ppu.scx, ppu.lyc, ppu.bgp, ppu.obp0, ppu.obp1);
+        fields(io, ppu.wy, ppu.wx, ppu.window_line);
+        fields(io, ppu.bcps, ppu.ocps, ppu.bg_palette, ppu.obj_palette, ppu.bg_rgb, ppu.obj_rgb);
+        fields(io, ppu.line, ppu.frame_base, ppu.line_next, ppu.frame_count, ppu.fifo);
+
+        fields(io, mem.joypad.buttons, mem.joypad.select);
+        fields(io, mem.serial.data, mem.serial.control, mem.serial.cgb, mem.serial.transfer_end, mem.serial.incoming);
+    }
+
+    auto header(CPU::MCB1 const& mem) noexcept -> Prefix {
+        return {State::magic, State::version, State::rom_id(mem), static_cast<std::uint32_t>(mem.eram_size)};
+    }
+}
+
+auto State::size(CPU const& cpu, CPU::MCB1 const& mem) noexcept -> std::size_t {
+    auto io = Counter{};
+    // Passes that only read the machine share the non-const transfer list
+    transfer(io, const_cast<CPU&>(cpu), const_cast<CPU::MCB1&>(mem));
+    return sizeof(Prefix) + io.size;
+}
+
+auto State::save(CPU const& cpu, CPU::MCB1 const& mem, byte_t* out, std::size_t size) noexcept -> std::size_t {
+    auto const total = State::size(cpu, mem);
+    if (size < total) {
+        return 0;
+    }
+    auto const head = header(mem);
+    std::memcpy(out, &head, sizeof(head));
+    auto io = Writer{out + sizeof(head)};
+    transfer(io, const_cast<CPU&>(cpu), const_cast<CPU::MCB1&>(mem));
+    return total;
+}
+
+auto State::load(CPU& cpu, CPU::MCB1& mem, byte_t const* in, std::size_t size) noexcept -> bool {
+    auto head = Prefix{};
+    if (size != State::size(cpu, mem)) {
+        return false;
+    }
+    std::memcpy(&head, in, sizeof(head));
+    auto const expected = header(mem);
+    if (head.magic != expected.magic || head.version != expected.version || head.rom_id != expected.rom_id ||
+        head.eram_size != expected.eram_size) {
+        return false;
+    }
+    auto io = Reader{in + sizeof(head)};
+    transfer(io, cpu, mem);
+
+    // Derived state, host side queues keep whatever the host pushed
+    mem.remap();
+    mem.event_deadline = mem.cycles;
+    mem.joypad_next = CPU::MCB1::never;
+    mem.serial_next = CPU::MCB1::never;
+    mem.apu.left.clear();
+    mem.apu.right.clear();
+    return true;
+}
+
+auto State::rom_id(CPU::MCB1 const& mem) noexcept -> std::uint32_t {
+    return static_cast<std::uint32_t>(mem.ROM[0x14D] | mem.ROM[0x14E] << 8 | mem.ROM[0x14F] << 16 | mem.ROM[0x143] << 24);
+}
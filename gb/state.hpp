@@ -0,0 +1,23 @@
+#pragma once
+#include "cpu.hpp"
+
+/// Machine state snapshots.
+/// Everything the emulation depends on is written field by field in host byte order, ROM and rendered output are
+/// not part of it, neither is the boot ROM image. A snapshot only loads into a machine running the same ROM and with the same ERAM size.
+/// Audio already synthesized but not read yet is dropped on load.
+struct gb::State final {
+    static constexpr std::uint32_t magic = 0x54534247;  // "GBST"
+    static constexpr std::uint32_t version = 4;
+
+    /// Bytes save() needs for this machine
+    static auto size(CPU const& cpu, CPU::MCB1 const& mem) noexcept -> std::size_t;
+
+    /// Returns bytes written, 0 if out is too small
+    static auto save(CPU const& cpu, CPU::MCB1 const& mem, byte_t* out, std::size_t size) noexcept -> std::size_t;
+
+    /// Returns false and leaves the machine untouched if the snapshot does not fit it
+    static auto load(CPU& cpu, CPU::MCB1& mem, byte_t const* in, std::size_t size) noexcept -> bool;
+
+    /// Identifies the ROM a snapshot belongs to, taken from the header checksums
+    static auto rom_id(CPU::MCB1 const& mem) noexcept -> std::uint32_t;
+};
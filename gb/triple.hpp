@@ -0,0 +1,37 @@
+#pragma once
+#include <atomic>
+
+#include "common.hpp"
+
+/// Lock-free triple buffer.
+/// Producer always has a slot to write into and consumer always gets the most recently published slot, a slow
+/// consumer simply skips frames instead of stalling the producer.
+template <typename T>
+struct gb::Triple final {
+    static constexpr byte_t fresh = 0x4;
+    static constexpr std::size_t cache_line = 64;
+
+    std::array<T, 3> slots = {};
+    alignas(cache_line) std::atomic<byte_t> middle = 1;
+    alignas(cache_line) byte_t back = 0;
+    alignas(cache_line) byte_t front = 2;
+
+    /// Producer side
+    auto write_buffer() noexcept -> T& { return slots[back]; }
+
+    auto publish() noexcept -> void { back = middle.exchange(back | fresh, std::memory_order_acq_rel) & 3; }
+
+    /// Consumer side, returns newly published slot or nullptr when nothing changed since last call
+    auto read() noexcept -> T const* {
+        if (!(middle.load(std::memory_order_relaxed) & fresh)) {
+            return nullptr;
+        }
+        front = middle.exchange(front, std::memory_order_acq_rel) & 3;
+        return &slots[front];
+    }
+
+    auto latest() noexcept -> T const& {
+        read();
+        return slots[front];
+    }
+};
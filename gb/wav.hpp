@@ -0,0 +1,56 @@
+#pragma once
+#include <cstdio>
+
+#include "common.hpp"
+
+/// Minimal 16bit PCM WAV writer, header is patched with final sizes on close
+struct gb::WAV final {
+    std::FILE* file = {};
+    std::uint32_t rate = {};
+    std::uint16_t channels = {};
+    std::uint32_t data_size = {};
+
+    WAV() = default;
+    WAV(WAV const&) = delete;
+    WAV& operator=(WAV const&) = delete;
+    ~WAV() { close(); }
+
+    auto open(char const* filename, std::uint32_t sample_rate, std::uint16_t channel_count) noexcept -> bool {
+        close();
+        file = std::fopen(filename, "wb");
+        rate = sample_rate;
+        channels = channel_count;
+        data_size = 0;
+        return file && write_header();
+    }
+
+    auto write(std::int16_t const* samples, std::size_t frames) noexcept -> void {
+        if (!file) {
+            return;
+        }
+        auto const count = std::fwrite(samples, sizeof(std::int16_t) * channels, frames, file);
+        data_size += static_cast<std::uint32_t>(count * sizeof(std::int16_t) * channels);
+    }
+
+    auto close() noexcept -> void {
+        if (!file) {
+            return;
+        }
+        std::fseek(file, 0, SEEK_SET);
+        write_header();
+        std::fclose(file);
+        file = nullptr;
+    }
+
+    auto write_header() noexcept -> bool {
+        auto const put16 = [this](std::uint16_t value) {
+            byte_t const bytes[2] = {(byte_t)value, (byte_t)(value >> 8)};
+            return std::fwrite(bytes, 1, 2, file) == 2;
+        };
+        auto const put32 = [&](std::uint32_t value) { return put16((word_t)value) && put16((word_t)(value >> 16)); };
+        auto const block_align = static_cast<std::uint16_t>(channels * sizeof(std::int16_t));
+        return std::fwrite("RIFF", 1, 4, file) == 4 && put32(36 + data_size) && std::fwrite("WAVEfmt ", 1, 8, file) == 8 &&
+               put32(16) && put16(1) && put16(channels) && put32(rate) && put32(rate * block_align) &&
+               put16(block_align) && put16(16) && std::fwrite("data", 1, 4, file) == 4 && put32(data_size);
+    }
+};
@@ -1,50 +1,472 @@
+#include <chrono>
+#include <cstring>
 #include <filesystem>
-#include <fstream>
 #include <iostream>
+#include <map>
 #include <memory>
+#include <string>
+#include <thread>
+#include <vector>
 
+#include "gb/boot.hpp"
+#include "gb/catalog.hpp"
+#include "gb/compat.hpp"
 #include "gb/cpu.hpp"
+#include "gb/debugger.hpp"
+#include "gb/disasm.hpp"
+#include "gb/gdb.hpp"
+#include "gb/golden.hpp"
+#include "gb/header.hpp"
+#include "gb/link.hpp"
+#include "gb/machine.hpp"
 #include "gb/mcb1.hpp"
+#include "gb/metrics.hpp"
+#include "gb/realtime.hpp"
+#include "gb/save.hpp"
+#include "gb/wav.hpp"
 
 using namespace gb;
 
-int main() {
-    auto mem = std::make_unique<CPU::MCB1>();
-    auto cpu = CPU{};
-    constexpr auto filename = "tests/cpu_instrs/cpu_instrs.gb";
+static auto report(CPU::Status status) -> void {
+    switch (status) {
+        case CPU::Status::OK:
+            break;
+        case CPU::Status::BAD:
+            printf("Bad instruction!\n");
+            break;
+        case CPU::Status::HALT:
+            printf("Halt!\n");
+            break;
+        case CPU::Status::STOP:
+            printf("Stop!\n");
+            break;
+        case CPU::Status::BREAK:
+            printf("Break!\n");
+            break;
+    }
+}
+
+/// Runs one frame an instruction at a time, appending a record per instruction for offline annotation
+static auto run_traced(CPU& cpu, CPU::MCB1& mem, std::uint64_t until, std::vector<Disasm::Record>& trace)
+    -> CPU::Status {
+    while (mem.cycles < until) {
+        auto& r = trace.emplace_back();
+        r.pc = cpu.reg_ip;
+        r.sp = cpu.reg_sp;
+        r.bank = r.pc >= 0x4000 && r.pc < 0x8000 ? mem.rom_bank : 0;
+        r.a = cpu.reg_a;
+        r.f = cpu.reg_f.into_byte();
+        r.b = cpu.reg_b;
+        r.c = cpu.reg_c;
+        r.d = cpu.reg_d;
+        r.e = cpu.reg_e;
+        r.h = cpu.reg_h;
+        r.l = cpu.reg_l;
+        for (word_t i = 0; i != 3; ++i) {
+            r.code[i] = mem.peek(static_cast<word_t>(r.pc + i));
+        }
+        if (auto const status = mem.run(cpu, mem.cycles + 1); status != CPU::Status::OK) {
+            return status;
+        }
+    }
+    return CPU::Status::OK;
+}
+
+/// Prometheus text, or JSON when filename ends in .json
+static auto write_metrics(char const* filename, Metrics const& metrics, std::string_view rom) -> void {
+    auto const text = std::filesystem::path(filename).extension() == ".json" ? metrics.json(rom)
+                                                                             : metrics.prometheus(rom);
+    auto const file = std::unique_ptr<FILE, decltype(&fclose)>(fopen(filename, "wb"), &fclose);
+    if (!file || fwrite(text.data(), 1, text.size(), file.get()) != text.size()) {
+        printf("Failed to write metrics file!");
+    }
+}
+
+/// Compares every shot of the manifest against what the ROMs produce now, or stores that with update.
+/// Returns the exit code, 1 for any mismatch, missing hash or ROM that fails to load. The counters of every ROM are
+/// summed into metrics_filename when set, labelled with the manifest name.
+static auto run_golden(char const* manifest, bool update, char const* png_dir, unsigned jobs, Compat const& compat,
+                       char const* metrics_filename) -> int {
+    using namespace std::chrono;
+    auto golden = Golden{};
+    golden.compat = compat;
+    if (!golden.load(manifest)) {
+        printf("Failed to read golden manifest!\n");
+        return 1;
+    }
+    auto error = std::error_code{};
+    if (png_dir && !std::filesystem::create_directories(png_dir, error) && error) {
+        printf("Failed to create PNG directory!\n");
+        return 1;
+    }
+    auto failed = std::vector<std::string>{};
+    auto const start = steady_clock::now();
+    auto metrics = Metrics{};
+    auto const shots = golden.run(std::filesystem::path(manifest).parent_path(), jobs, png_dir ? png_dir : "", failed,
+                                  metrics_filename ? &metrics : nullptr);
+    auto const seconds = duration<double>(steady_clock::now() - start).count();
+
+    for (auto const& rom : failed) {
+        printf("%s: failed to load\n", rom.c_str());
+    }
+    auto mismatches = 0, missing = 0;
+    auto emulated = std::map<std::string, std::uint64_t>{};
+    for (auto i = std::size_t{}; i != golden.entries.size(); ++i) {
+        auto& entry = golden.entries[i];
+        auto const& shot = shots[i];
+        if (std::find(failed.begin(), failed.end(), entry.rom) != failed.end()) {
+            continue;
+        }
+        auto& last = emulated[entry.rom];
+        last = std::max(last, shot.frame);
+        if (!entry.known) {
+            missing += !update;
+        } else if (entry.expected.hash != shot.hash) {
+            ++mismatches;
+            printf("%s frame %llu: %016llx, expected %016llx, perceptual distance %d/64\n", entry.rom.c_str(),
+                   static_cast<unsigned long long>(shot.frame), static_cast<unsigned long long>(shot.hash),
+                   static_cast<unsigned long long>(entry.expected.hash),
+                   Golden::distance(shot.perceptual, entry.expected.perceptual));
+        }
+        if (update) {
+            entry.expected = shot;
+            entry.known = true;
+        }
+    }
+    if (update && !golden.save(manifest)) {
+        printf("Failed to write golden manifest!\n");
+        return 1;
+    }
+    auto frames = std::uint64_t{};
+    for (auto const& [rom, last] : emulated) {
+        frames += last;
+    }
+    if (metrics_filename) {
+        write_metrics(metrics_filename, metrics, std::filesystem::path(manifest).filename().string());
+    }
+    printf("%zu shots of %zu ROMs, %d mismatches, %d without hash, %.0f frames/s (%.0fx real time)\n",
+           golden.entries.size(), emulated.size(), mismatches, missing, static_cast<double>(frames) / seconds,
+           static_cast<double>(frames) / seconds / Realtime::frame_rate);
+    return !update && (mismatches || missing || !failed.empty()) ? 1 : 0;
+}
+
+/// Paced mode, this thread presents frames and a second thread stands in for the audio device
+static auto run_realtime(CPU& cpu, CPU::MCB1& mem, long long frames, WAV& wav) -> void {
+    using namespace std::chrono;
+    auto realtime = Realtime{cpu, mem};
+    realtime.frame_limit = frames;
+    realtime.sync_audio(0.1);
+    realtime.start();
+
+    auto audio = std::thread([&] {
+        auto samples = std::vector<std::int16_t>(Realtime::audio_capacity);
+        auto const start = steady_clock::now();
+        auto consumed = std::uint64_t{};
+        while (realtime.running.load(std::memory_order_acquire)) {
+            std::this_thread::sleep_for(milliseconds(10));
+            auto const elapsed = duration<double>(steady_clock::now() - start).count();
+            auto const due = static_cast<std::uint64_t>(elapsed * APU::sample_rate_default) * 2;
+            auto const count = realtime.audio.pop(samples.data(), std::min<std::size_t>(due - consumed, samples.size()));
+            consumed = due;
+            wav.write(samples.data(), count / 2);
+        }
+    });
+
+    auto presented = std::uint64_t{};
+    auto last = steady_clock::now();
+    auto last_frames = std::uint64_t{};
+    while (realtime.running.load(std::memory_order_acquire)) {
+        std::this_thread::sleep_for(milliseconds(16));
+        if (realtime.video.read()) {
+            ++presented;
+        }
+        if (auto const now = steady_clock::now(); now - last >= seconds(1)) {
+            auto const emulated = realtime.frames.load(std::memory_order_relaxed);
+            printf("emulated: %llu fps, presented: %llu, audio queued: %zu\n",
+                   static_cast<unsigned long long>(emulated - last_frames),
+                   static_cast<unsigned long long>(presented),
+                   realtime.audio.size() / 2);
+            last = now;
+            last_frames = emulated;
+            presented = 0;
+        }
+    }
+    realtime.stop();
+    audio.join();
+    report(realtime.status.load());
+}
+
+int main(int argc, char** argv) {
+    // Registers and memory share one arena block, serial output goes to stdout instead of the machine's string
+    auto const machine = std::make_unique<Machine>();
+    auto& cpu = machine->cpu;
+    auto const mem = &machine->mem;
+    mem->serial.file = stdout;
+    mem->serial.callback = {};
+    char const* filename = "tests/cpu_instrs/cpu_instrs.gb";
     // constexpr auto filename = "tests/cpu_instrs/individual/11-op a,(hl).gb";
+    char const* wav_filename = nullptr;
+    char const* sym_filename = nullptr;
+    char const* trace_filename = nullptr;
+    char const* annotate_filename = nullptr;
+    char const* gdb_address = nullptr;
+    char const* serial_filename = nullptr;
+    char const* link_filename = nullptr;
+    char const* save_filename = nullptr;
+    char const* boot_filename = nullptr;
+    char const* metrics_filename = nullptr;
+    char const* golden_filename = nullptr;
+    char const* png_dir = nullptr;
+    bool golden_update = false;
+    char const* ppu_name = nullptr;
+    char const* compat_filename = nullptr;
+    char const* catalog_filename = nullptr;
+    auto jobs = std::max(std::thread::hardware_concurrency(), 1u);
+    long long save_interval = 1000;
+    bool disasm = false;
+    long long disasm_bank = -1;
+    auto debugger = Debugger{};
+    long long frames = -1;
+    bool realtime = false;
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--wav") && i + 1 < argc) {
+            wav_filename = argv[++i];
+        } else if (!strcmp(argv[i], "--frames") && i + 1 < argc) {
+            frames = std::stoll(argv[++i]);
+        } else if (!strcmp(argv[i], "--realtime")) {
+            realtime = true;
+        } else if (!strcmp(argv[i], "--sym") && i + 1 < argc) {
+            sym_filename = argv[++i];
+        } else if (!strcmp(argv[i], "--trace") && i + 1 < argc) {
+            trace_filename = argv[++i];
+        } else if (!strcmp(argv[i], "--annotate") && i + 1 < argc) {
+            annotate_filename = argv[++i];
+        } else if (!strcmp(argv[i], "--break") && i + 1 < argc) {
+            // [bank:]address in hex
+            auto const text = std::string(argv[++i]);
+            auto const colon = text.find(':');
+            auto const bank = colon == text.npos ? -1 : std::stoi(text.substr(0, colon), nullptr, 16);
+            auto const address = std::stoi(text.substr(colon == text.npos ? 0 : colon + 1), nullptr, 16);
+            debugger.add_breakpoint(static_cast<word_t>(address), bank);
+        } else if (!strcmp(argv[i], "--watch") && i + 1 < argc) {
+            auto const address = static_cast<word_t>(std::stoi(argv[++i], nullptr, 16));
+            debugger.add(Debugger::Kind::WRITE, address, address);
+        } else if (!strcmp(argv[i], "--gdb") && i + 1 < argc) {
+            gdb_address = argv[++i];
+        } else if (!strcmp(argv[i], "--serial") && i + 1 < argc) {
+            serial_filename = argv[++i];
+        } else if (!strcmp(argv[i], "--link") && i + 1 < argc) {
+            link_filename = argv[++i];
+        } else if (!strcmp(argv[i], "--save") && i + 1 < argc) {
+            save_filename = argv[++i];
+        } else if (!strcmp(argv[i], "--boot") && i + 1 < argc) {
+            boot_filename = argv[++i];
+        } else if (!strcmp(argv[i], "--metrics") && i + 1 < argc) {
+            metrics_filename = argv[++i];
+        } else if (!strcmp(argv[i], "--golden") && i + 1 < argc) {
+            golden_filename = argv[++i];
+        } else if (!strcmp(argv[i], "--update")) {
+            golden_update = true;
+        } else if (!strcmp(argv[i], "--png") && i + 1 < argc) {
+            png_dir = argv[++i];
+        } else if (!strcmp(argv[i], "--jobs") && i + 1 < argc) {
+            jobs = static_cast<unsigned>(std::max(std::stoi(argv[++i]), 1));
+        } else if (!strcmp(argv[i], "--ppu") && i + 1 < argc) {
+            ppu_name = argv[++i];
+        } else if (!strcmp(argv[i], "--compat") && i + 1 < argc) {
+            compat_filename = argv[++i];
+        } else if (!strcmp(argv[i], "--catalog") && i + 1 < argc) {
+            catalog_filename = argv[++i];
+        } else if (!strcmp(argv[i], "--save-interval") && i + 1 < argc) {
+            save_interval = std::stoll(argv[++i]);
+        } else if (!strcmp(argv[i], "--disasm")) {
+            disasm = true;
+        } else if (!strcmp(argv[i], "--bank") && i + 1 < argc) {
+            disasm_bank = std::stoll(argv[++i]);
+        } else {
+            filename = argv[i];
+        }
+    }
 
-    if (auto file = std::ifstream(filename, std::ios::binary);
-        !file.read(reinterpret_cast<char*>(mem->ROM.data()), std::filesystem::file_size(filename))) {
+    auto dis = Disasm{};
+    if (sym_filename && !dis.load_symbols(sym_filename)) {
+        printf("Failed to read symbol file!");
+        return 0;
+    }
+    if (annotate_filename) {
+        auto const file = std::unique_ptr<FILE, decltype(&fclose)>(fopen(annotate_filename, "rb"), &fclose);
+        if (!file) {
+            printf("Failed to open trace file!");
+            return 0;
+        }
+        dis.annotate(stdout, file.get());
+        return 0;
+    }
+    // --ppu picks the renderer for everything, otherwise the database may pick one per ROM
+    auto compat = Compat{};
+    if (compat_filename && !compat.load(compat_filename)) {
+        printf("Failed to read compatibility database!");
+        return 0;
+    }
+    if (ppu_name && !(compat.forced = Compat::parse(ppu_name))) {
+        printf("Unknown renderer, expected scanline or fifo!");
+        return 0;
+    }
+    if (golden_filename) {
+        return run_golden(golden_filename, golden_update, png_dir, jobs, compat, metrics_filename);
+    }
+    auto catalog = Catalog{};
+    if (catalog_filename && !catalog.load(catalog_filename)) {
+        printf("Failed to read catalog!");
+        return 0;
+    }
+    // Warns about the header, then takes idle loops from the catalog when there is one. The catalog also keeps the
+    // database's renderer for the ROM, refreshed whenever --compat is given, so later runs get it without the file.
+    // --ppu only ever applies to this run.
+    auto const prepare = [&](char const* name, CPU::MCB1& rom, std::size_t size) {
+        auto const header = Header::parse(rom.ROM.data(), size);
+        for (auto const& problem : header.problems(size)) {
+            fprintf(stderr, "%s: %s\n", name, problem.c_str());
+        }
+        auto renderer = compat.listed(rom.ROM.data(), size);
+        if (!catalog_filename) {
+            rom.find_idle_loops(size);
+        } else if (auto& entry = catalog.attach(rom, size); compat_filename && entry.renderer != renderer) {
+            entry.renderer = renderer;
+            catalog.changed = true;
+        } else if (!compat_filename && entry.renderer) {
+            renderer = *entry.renderer;
+        }
+        rom.ppu.renderer = compat.forced.value_or(renderer);
+        return header;
+    };
+
+    auto const rom_size = Machine::load(*mem, filename);
+    if (!rom_size) {
         printf("Failed to read file!");
         return 0;
     }
-    cpu.reg_a = 0x1;
-    cpu.reg_f = CPU::Flags::from_byte(0xB0);
-    cpu.reg_b = 0x00;
-    cpu.reg_c = 0x13;
-    cpu.reg_d = 0x00;
-    cpu.reg_e = 0xD8;
-    cpu.reg_h = 0x01;
-    cpu.reg_l = 0x4D;
-    cpu.reg_sp = 0xFFFE;
-    cpu.reg_ip = 0x100;
-    for (long long c = 0; true; ++c) {
-        //cpu.trace(*mem);
-        auto const result = cpu.step(*mem);
-        switch (result) {
-            case CPU::Status::OK:
-                break;
-            case CPU::Status::BAD:
-                printf("Bad instruction!\n");
-                return 0;
-            case CPU::Status::HALT:
-                printf("Halt!\n");
-                return 0;
-            case CPU::Status::STOP:
-                printf("Stop!\n");
-                return 0;
+    auto const header = prepare(filename, *mem, rom_size);
+    if (disasm) {
+        auto const banks = (rom_size + 0x3FFF) / 0x4000;
+        for (std::size_t bank = 0; bank != banks; ++bank) {
+            if (disasm_bank < 0 || static_cast<std::size_t>(disasm_bank) == bank) {
+                dis.disassemble_bank(stdout, mem->ROM.data(), rom_size, static_cast<std::uint32_t>(bank));
+            }
+        }
+        return 0;
+    }
+    auto const trace_file =
+        std::unique_ptr<FILE, decltype(&fclose)>(trace_filename ? fopen(trace_filename, "wb") : nullptr, &fclose);
+    if (trace_filename && !trace_file) {
+        printf("Failed to open trace file!");
+        return 0;
+    }
+    auto trace = std::vector<Disasm::Record>{};
+    mem->debugger = &debugger;
+    auto gdb = std::unique_ptr<GDB>{};
+    if (gdb_address) {
+        gdb = std::make_unique<GDB>(cpu, *mem, debugger);
+        if (!gdb->listen(gdb_address)) {
+            printf("Failed to listen on %s!", gdb_address);
+            return 0;
+        }
+        printf("Waiting for GDB on %s\n", gdb_address);
+        fflush(stdout);
+    }
+    auto wav = WAV{};
+    if (wav_filename && !wav.open(wav_filename, APU::sample_rate_default, 2)) {
+        printf("Failed to open wav file!");
+        return 0;
+    }
+    auto const serial_file =
+        std::unique_ptr<FILE, decltype(&fclose)>(serial_filename ? fopen(serial_filename, "wb") : nullptr, &fclose);
+    if (serial_filename && !serial_file) {
+        printf("Failed to open serial file!");
+        return 0;
+    }
+    if (serial_file) {
+        mem->serial.file = serial_file.get();
+    }
+    auto samples = std::vector<std::int16_t>{};
+    if (boot_filename && !Boot::install(*mem, boot_filename)) {
+        printf("Failed to read boot ROM, expected 256 or 2304 bytes!");
+        return 0;
+    }
+    Boot::start(cpu, *mem);
+
+    // Battery backed carts keep ERAM in a .sav next to the ROM unless --save names another file
+    auto save = Save(*mem);
+    if (save_filename || header.battery) {
+        auto const path = save_filename ? std::filesystem::path(save_filename)
+                                        : std::filesystem::path(filename).replace_extension(".sav");
+        save.interval = std::chrono::milliseconds{save_interval};
+        if (!save.open(path.c_str(), Save::ram_size(header))) {
+            printf("Failed to open save file!");
+            return 0;
+        }
+    }
+
+    // Second instance on the other end of the cable, its output is only kept in its ring
+    auto peer = std::unique_ptr<Machine>{};
+    auto link = std::unique_ptr<Link>{};
+    if (link_filename) {
+        peer = std::make_unique<Machine>();
+        auto const peer_size = Machine::load(peer->mem, link_filename);
+        if (!peer_size) {
+            printf("Failed to read link file!");
+            return 0;
+        }
+        prepare(link_filename, peer->mem, peer_size);
+        peer->mem.serial.callback = {};
+        if (boot_filename) {
+            Boot::install(peer->mem, mem->BOOT.data(), mem->boot_size);
         }
+        Boot::start(peer->cpu, peer->mem);
+        link = std::make_unique<Link>(cpu, *mem, peer->cpu, peer->mem);
+    }
+    if (catalog.changed && !catalog.save(catalog_filename)) {
+        printf("Failed to write catalog!");
+        return 0;
+    }
+    if (realtime) {
+        run_realtime(cpu, *mem, frames, wav);
+        if (metrics_filename) {
+            write_metrics(metrics_filename, Metrics::snapshot(*mem), Metrics::title(*mem));
+        }
+        return 0;
+    }
+    for (long long frame = 0; frames < 0 || frame < frames; ++frame) {
+        auto const frame_end = static_cast<std::uint64_t>(frame + 1) * frame_cycles;
+        auto const status = gdb          ? gdb->run(frame_end)
+                            : trace_file ? run_traced(cpu, *mem, frame_end, trace)
+                            : link       ? link->run(frame_end)
+                                         : mem->run(cpu, frame_end);
+        mem->serial.flush();
+        if (trace_file) {
+            fwrite(trace.data(), sizeof(Disasm::Record), trace.size(), trace_file.get());
+            trace.clear();
+        }
+        if (status != CPU::Status::OK) {
+            report(status);
+            if (metrics_filename) {
+                write_metrics(metrics_filename, Metrics::snapshot(*mem), Metrics::title(*mem));
+            }
+            if (status == CPU::Status::BREAK) {
+                auto const& hit = debugger.hit;
+                printf("Point %d at $%04X = $%02X\n", hit.id, hit.address, hit.value);
+                cpu.trace(*mem);
+            }
+            return 0;
+        }
+        mem->video_sync();
+        mem->apu.end_frame(mem->cycles);
+        samples.resize(mem->apu.samples_avail() * 2);
+        auto const count = mem->apu.read_samples(samples.data(), samples.size() / 2);
+        wav.write(samples.data(), count);
+    }
+    if (metrics_filename) {
+        write_metrics(metrics_filename, Metrics::snapshot(*mem), Metrics::title(*mem));
     }
     return 0;
 }
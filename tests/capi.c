@@ -0,0 +1,149 @@
+/* Smoke test of the C interface, built as C so the header stays valid C.
+ * Runs two instances of a small ROM that counts over the serial port and checks that a snapshot replays exactly. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "gb/libgb.h"
+
+#define CHECK(condition)                                              \
+    do {                                                              \
+        if (!(condition)) {                                           \
+            printf("%s:%d: %s failed\n", __FILE__, __LINE__, #condition); \
+            return 1;                                                 \
+        }                                                             \
+    } while (0)
+
+static unsigned char rom[0x8000];
+
+/* Sends "OK", then an incrementing counter kept at $C000 forever */
+static void build_rom(void) {
+    static unsigned char const code[] = {
+        0x3E, 'O',  0xE0, 0x01, 0x3E, 0x81, 0xE0, 0x02, 0xF0, 0x02, 0xCB, 0x7F, 0x20, 0xFA,
+        0x3E, 'K',  0xE0, 0x01, 0x3E, 0x81, 0xE0, 0x02, 0xF0, 0x02, 0xCB, 0x7F, 0x20, 0xFA,
+        0xFA, 0x00, 0xC0, 0x3C, 0xEA, 0x00, 0xC0, 0xE0, 0x01, 0x3E, 0x81, 0xE0, 0x02, 0xF0,
+        0x02, 0xCB, 0x7F, 0x20, 0xFA, 0x18, 0xEB,
+    };
+    memcpy(rom + 0x100, code, sizeof(code));
+}
+
+int main(void) {
+    build_rom();
+    CHECK(gb_api_version() == GB_API_VERSION);
+
+    gb_instance* a = gb_create();
+    gb_instance* b = gb_create();
+    CHECK(a && b);
+    CHECK(gb_load_rom(a, rom, sizeof(rom)) == 0);
+    CHECK(gb_load_rom(b, rom, sizeof(rom)) == 0);
+    CHECK(gb_load_rom(a, rom, 0) != 0);
+    /* The pixel FIFO renderer on b changes nothing the checks below look at */
+    CHECK(gb_set_renderer(b, 2) != 0);
+    CHECK(gb_set_renderer(b, GB_RENDERER_FIFO) == 0);
+
+    size_t size = 0;
+    CHECK(gb_run_frame(a) == GB_STATUS_OK);
+    CHECK(gb_cycles(a) >= GB_FRAME_CYCLES && gb_cycles(a) < GB_FRAME_CYCLES + 32);
+    uint8_t const* serial = gb_serial(a, &size);
+    CHECK(size > 2 && memcmp(serial, "OK", 2) == 0);
+    CHECK(gb_framebuffer(a) != NULL);
+    uint8_t* rgba = malloc(GB_SCREEN_WIDTH * GB_SCREEN_HEIGHT * 4);
+    CHECK(rgba != NULL);
+    gb_framebuffer_rgba(a, rgba);
+    CHECK(rgba[0] == (uint8_t)(gb_framebuffer(a)[0] >> 16) && rgba[3] == (uint8_t)(gb_framebuffer(a)[0] >> 24));
+    free(rgba);
+
+    /* Snapshot, run, restore and run again must give the same output */
+    size_t const state_size = gb_state_size(a);
+    unsigned char* state = malloc(state_size);
+    uint64_t const saved_cycles = gb_cycles(a);
+    CHECK(state && gb_state_save(a, state, state_size - 1) == 0);
+    CHECK(gb_state_save(a, state, state_size) == state_size);
+
+    CHECK(gb_run(a, 3 * GB_FRAME_CYCLES + 1234) == GB_STATUS_OK);
+    size_t first_size = 0;
+    serial = gb_serial(a, &first_size);
+    unsigned char first[4096];
+    CHECK(first_size > 0 && first_size <= sizeof(first));
+    memcpy(first, serial, first_size);
+    uint64_t const first_cycles = gb_cycles(a);
+    size_t samples = 0;
+    CHECK(gb_audio(a, &samples) != NULL && samples > 0);
+
+    CHECK(gb_state_load(a, state, state_size - 1) != 0);
+    CHECK(gb_state_load(a, state, state_size) == 0);
+    CHECK(gb_run(a, 3 * GB_FRAME_CYCLES + 1234) == GB_STATUS_OK);
+    serial = gb_serial(a, &size);
+    CHECK(gb_cycles(a) == first_cycles);
+    CHECK(size == first_size && memcmp(serial, first, size) == 0);
+
+    /* The other instance is unaffected and can take the snapshot too */
+    CHECK(gb_cycles(b) == 0);
+    CHECK(gb_state_load(b, state, state_size) == 0);
+    CHECK(gb_cycles(b) == saved_cycles);
+
+    /* Rewind two frames back and replay them */
+    CHECK(gb_rewind(a, 0) == -1);
+    CHECK(gb_rewind_enable(a, 60, 1 << 20) == 0);
+    uint64_t frame_cycles[5];
+    unsigned char replay[2][4096];
+    size_t replay_size[2];
+    for (int frame = 0; frame != 5; ++frame) {
+        CHECK(gb_run_frame(a) == GB_STATUS_OK);
+        frame_cycles[frame] = gb_cycles(a);
+        serial = gb_serial(a, &size);
+        if (frame >= 3) {
+            CHECK(size <= sizeof(replay[0]));
+            memcpy(replay[frame - 3], serial, size);
+            replay_size[frame - 3] = size;
+        }
+    }
+    size_t history_bytes = 0;
+    CHECK(gb_rewind_history(a, &history_bytes) == 4);
+    CHECK(gb_rewind(a, 2) == 2);
+    CHECK(gb_cycles(a) == frame_cycles[2]);
+    for (int frame = 3; frame != 5; ++frame) {
+        CHECK(gb_run_frame(a) == GB_STATUS_OK);
+        CHECK(gb_cycles(a) == frame_cycles[frame]);
+        serial = gb_serial(a, &size);
+        CHECK(size == replay_size[frame - 3] && memcmp(serial, replay[frame - 3], size) == 0);
+    }
+    CHECK(gb_rewind(a, 100) == 4);
+    CHECK(gb_cycles(a) == frame_cycles[0]);
+
+    /* A boot ROM runs first and unmaps itself by writing 0xFF50, then the cartridge starts at 0x100 */
+    static unsigned char boot[0x100] = {0x3E, 'B', 0xE0, 0x01, 0x3E, 0x81, 0xE0, 0x02, 0xF0, 0x02, 0xCB, 0x7F, 0x20, 0xFA};
+    boot[0xFC] = 0x3E;
+    boot[0xFD] = 0x01;
+    boot[0xFE] = 0xE0;
+    boot[0xFF] = 0x50;
+    CHECK(gb_set_boot_rom(b, boot, sizeof(boot) - 1) != 0);
+    CHECK(gb_set_boot_rom(b, boot, sizeof(boot)) == 0);
+    CHECK(gb_load_rom(b, rom, sizeof(rom)) == 0);
+    CHECK(gb_cycles(b) == 0);
+    CHECK(gb_run_frame(b) == GB_STATUS_OK);
+    serial = gb_serial(b, &size);
+    CHECK(size > 3 && memcmp(serial, "BOK", 3) == 0);
+    CHECK(gb_set_boot_rom(b, NULL, 0) == 0);
+    CHECK(gb_load_rom(b, rom, sizeof(rom)) == 0);
+    CHECK(gb_run_frame(b) == GB_STATUS_OK);
+    serial = gb_serial(b, &size);
+    CHECK(size > 2 && memcmp(serial, "OK", 2) == 0);
+
+    /* Metrics of that frame, the ROM polls the serial port so it touches I/O all the time */
+    char metrics[2048];
+    size_t const metrics_size = gb_metrics(b, GB_METRICS_PROMETHEUS, NULL, 0);
+    CHECK(metrics_size > 0 && metrics_size < sizeof(metrics));
+    CHECK(gb_metrics(b, GB_METRICS_PROMETHEUS, metrics, sizeof(metrics)) == metrics_size);
+    CHECK(strlen(metrics) == metrics_size && strstr(metrics, "# TYPE gb_instructions_total counter\n"));
+    CHECK(strstr(metrics, "gb_halt_total{rom=\"\"} 0\n") && !strstr(metrics, "gb_io_reads_total{rom=\"\"} 0\n"));
+    CHECK(gb_metrics(b, GB_METRICS_JSON, metrics, 8) > 8 && strcmp(metrics, "{\"rom\":") == 0);
+    CHECK(gb_metrics(b, GB_METRICS_JSON, metrics, sizeof(metrics)) > 0 && strstr(metrics, "\"bad\":0,"));
+    CHECK(gb_metrics(b, 2, metrics, sizeof(metrics)) == 0);
+
+    free(state);
+    gb_destroy(a);
+    gb_destroy(b);
+    printf("capi: ok\n");
+    return 0;
+}
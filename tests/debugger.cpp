@@ -0,0 +1,125 @@
+// Breakpoints and watchpoints on a running machine: execution points by ROM bank, read and write points, conditions
+// and removal, and points on pages the program never touches, which must leave the run exactly as without them.
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+#include "gb/boot.hpp"
+#include "gb/debugger.hpp"
+#include "gb/machine.hpp"
+#include "gb/state.hpp"
+
+using namespace gb;
+
+namespace {
+    int failures = 0;
+
+    auto check(bool condition, char const* what) -> void {
+        if (!condition) {
+            printf("%s failed\n", what);
+            ++failures;
+        }
+    }
+
+    /// Calls 0x4000 in banks 2 and 3, then increments the byte at 0xC000, forever
+    constexpr byte_t program[] = {
+        0x3E, 0x02,        // 0150 LD A, 2
+        0xEA, 0x00, 0x20,  // 0152 LD ($2000), A
+        0xCD, 0x00, 0x40,  // 0155 CALL $4000
+        0x3E, 0x03,        // 0158 LD A, 3
+        0xEA, 0x00, 0x20,  // 015A LD ($2000), A
+        0xCD, 0x00, 0x40,  // 015D CALL $4000
+        0x21, 0x00, 0xC0,  // 0160 LD HL, $C000
+        0x7E,              // 0163 LD A, (HL)
+        0x3C,              // 0164 INC A
+        0x77,              // 0165 LD (HL), A
+        0x18, 0xE8,        // 0166 JR $0150
+    };
+
+    /// 64 KiB MBC1 cartridge, bank n holds LD C, n; RET at 0x4000
+    auto build_rom() -> std::vector<byte_t> {
+        auto rom = std::vector<byte_t>(0x10000);
+        byte_t const entry[] = {0x00, 0xC3, 0x50, 0x01};
+        std::copy(std::begin(entry), std::end(entry), rom.begin() + 0x100);
+        std::copy(Boot::logo.begin(), Boot::logo.end(), rom.begin() + 0x104);
+        std::copy_n("POINTS", 6, rom.begin() + 0x134);
+        rom[0x147] = 0x01;
+        rom[0x148] = 0x01;
+        std::copy(std::begin(program), std::end(program), rom.begin() + 0x150);
+        for (auto bank = 1; bank != 4; ++bank) {
+            byte_t const routine[] = {0x0E, static_cast<byte_t>(bank), 0xC9};
+            std::copy(std::begin(routine), std::end(routine), rom.begin() + bank * 0x4000);
+        }
+        auto checksum = byte_t{};
+        for (auto address = 0x134; address != 0x14D; ++address) {
+            checksum = static_cast<byte_t>(checksum - rom[address] - 1);
+        }
+        rom[0x14D] = checksum;
+        return rom;
+    }
+
+    auto snapshot(Machine const& machine) -> std::vector<byte_t> {
+        auto state = std::vector<byte_t>(State::size(machine.cpu, machine.mem));
+        state.resize(State::save(machine.cpu, machine.mem, state.data(), state.size()));
+        return state;
+    }
+}
+
+int main() {
+    auto const rom = build_rom();
+    auto const watched = std::make_unique<Machine>();
+    auto const plain = std::make_unique<Machine>();
+    check(watched->load(rom.data(), rom.size()) && plain->load(rom.data(), rom.size()), "load");
+    auto debugger = Debugger{};
+    watched->mem.debugger = &debugger;
+
+    // Points on pages the program never uses, and on 0x4000 in a bank it never selects
+    auto const far_write = debugger.add(Debugger::Kind::WRITE, 0xD000, 0xD0FF);
+    auto const far_read = debugger.add(Debugger::Kind::READ, 0xD100, 0xD100);
+    auto const other_bank = debugger.add_breakpoint(0x4000, 1);
+    for (auto i = 0; i != 50; ++i) {
+        check(watched->run(23456 + i * 5) == CPU::Status::OK, "untouched points");
+        plain->run(23456 + i * 5);
+    }
+    check(snapshot(*watched) == snapshot(*plain), "untouched state");
+
+    // Execution point in bank 3 only, the call into bank 2 just before must not stop
+    auto const bank3 = debugger.add_breakpoint(0x4000, 3);
+    check(watched->run(frame_cycles) == CPU::Status::BREAK && debugger.hit.id == bank3, "bank breakpoint");
+    check(watched->cpu.reg_ip == 0x4000 && watched->cpu.reg_a == 3 && watched->cpu.reg_c == 2, "bank breakpoint place");
+    auto const count = watched->mem.peek(0xC000);
+    check(watched->run(frame_cycles) == CPU::Status::BREAK && watched->cpu.reg_ip == 0x4000, "step over");
+    check(watched->mem.peek(0xC000) == static_cast<byte_t>(count + 1), "step over loop");
+    check(debugger.remove(bank3) && !debugger.remove(bank3), "remove");
+
+    // Read point stops after the instruction that read
+    auto const read = debugger.add(Debugger::Kind::READ, 0xC000, 0xC000);
+    check(watched->run(frame_cycles) == CPU::Status::BREAK && debugger.hit.id == read, "read point");
+    check(debugger.hit.kind == Debugger::Kind::READ && debugger.hit.address == 0xC000, "read hit");
+    check(watched->cpu.reg_ip == 0x164, "read point place");
+    debugger.remove(read);
+
+    // Write point over two bytes reports the value written
+    auto const write = debugger.add(Debugger::Kind::WRITE, 0xBFFF, 0xC000);
+    check(watched->run(frame_cycles) == CPU::Status::BREAK && debugger.hit.id == write, "write point");
+    check(debugger.hit.kind == Debugger::Kind::WRITE && debugger.hit.address == 0xC000, "write hit");
+    check(debugger.hit.value == watched->mem.peek(0xC000) && watched->cpu.reg_ip == 0x166, "write point place");
+    debugger.remove(write);
+
+    // Condition runs after the address matched, earlier writes to the same byte pass
+    auto const conditional = debugger.add(Debugger::Kind::WRITE, 0xC000, 0xC000, -1,
+                                          [](CPU const& cpu, CPU::MCB1&) { return cpu.reg_a == 0x40; });
+    check(watched->run(frame_cycles * 60) == CPU::Status::BREAK && debugger.hit.id == conditional, "condition");
+    check(watched->mem.peek(0xC000) == 0x40, "condition value");
+    auto const& point = *std::find_if(debugger.points.begin(), debugger.points.end(),
+                                      [&](auto const& point) { return point.id == conditional; });
+    check(point.hits == 1, "condition hits");
+
+    // Without points the machine runs free again
+    for (auto const id : {conditional, far_write, far_read, other_bank}) {
+        check(debugger.remove(id), "remove all");
+    }
+    check(!debugger.armed() && watched->run(frame_cycles * 4) == CPU::Status::OK, "removed");
+    return failures ? 1 : 0;
+}
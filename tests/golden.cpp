@@ -0,0 +1,117 @@
+// Golden frames of a small generated ROM that draws tiles, a tile map and sprites computed by the CPU and scrolls
+// them every frame. Any change to how instructions execute or memory is accessed that alters a single pixel changes
+// the pinned hashes. Also covers the PNG encoder and a manifest run across threads with its summed counters.
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+#include "gb/golden.hpp"
+#include "gb/metrics.hpp"
+#include "gb/png.hpp"
+
+using namespace gb;
+
+namespace {
+    int failures = 0;
+
+    auto check(bool condition, char const* what) -> void {
+        if (!condition) {
+            printf("%s failed\n", what);
+            ++failures;
+        }
+    }
+
+    auto build_rom() -> std::vector<byte_t> {
+        static byte_t const code[] = {
+            // 0x8000 - 0x97FF = L ^ H, 0x9800 - 0x9BFF = L + H
+            0x21, 0x00, 0x80, 0x7D, 0xAC, 0x22, 0x7C, 0xFE, 0x98, 0x20, 0xF8, 0x7D, 0x84, 0x22,
+            0x7C, 0xFE, 0x9C, 0x20, 0xF8,
+            // 40 sprites on a diagonal, some flipped
+            0x21, 0x00, 0xFE, 0x0E, 0x00, 0x79, 0x87, 0x81, 0xC6, 0x10, 0x22, 0x79, 0x87, 0x87,
+            0xC6, 0x08, 0x22, 0x79, 0x22, 0x79, 0xE6, 0x60, 0x22, 0x0C, 0x79, 0xFE, 0x28, 0x20,
+            0xE8,
+            // Sprites on, every vblank SCX += 1, SCY -= 2 and the first sprite moves down
+            0x3E, 0x93, 0xE0, 0x40, 0x3E, 0xE4, 0xE0, 0x48, 0xF0, 0x44, 0xFE, 0x90, 0x20, 0xFA,
+            0xF0, 0x43, 0x3C, 0xE0, 0x43, 0xF0, 0x42, 0x3D, 0x3D, 0xE0, 0x42, 0xFA, 0x00, 0xFE,
+            0x3C, 0xEA, 0x00, 0xFE, 0xF0, 0x44, 0xFE, 0x90, 0x28, 0xFA, 0x18, 0xE0,
+        };
+        auto rom = std::vector<byte_t>(0x8000);
+        byte_t const entry[] = {0x00, 0xC3, 0x50, 0x01};
+        std::copy(std::begin(entry), std::end(entry), rom.begin() + 0x100);
+        std::copy(std::begin(code), std::end(code), rom.begin() + 0x150);
+        return rom;
+    }
+}
+
+int main() {
+    // Known answers of the checksums
+    check(PNG::crc32(reinterpret_cast<byte_t const*>("123456789"), 9) == 0xCBF43926, "crc32");
+    check(PNG::adler32(reinterpret_cast<byte_t const*>("Wikipedia"), 9) == 0x11E60398, "adler32");
+    byte_t const pixels[2 * 2 * 4] = {255, 0, 0, 255, 0, 255, 0, 255, 0, 0, 255, 255, 255, 255, 255, 0};
+    auto const png = PNG::encode(pixels, 2, 2);
+    check(png.size() == 8 + 25 + 12 + 2 + 5 + 2 * 9 + 4 + 12 && std::memcmp(png.data() + 1, "PNG", 3) == 0 &&
+              std::memcmp(png.data() + png.size() - 8, "IEND", 4) == 0,
+          "png layout");
+
+    auto const rom = build_rom();
+    std::vector<std::uint64_t> const frames = {5, 6, 60};
+    auto const shots = Golden::capture(rom.data(), rom.size(), frames);
+    Golden::Shot const pinned[] = {
+        {5, 0xd02b6da6360c21ae, 0xfdddedd1d9d8d9bb},
+        {6, 0x927871e13d4db78f, 0xbdddedd5d9dad9db},
+        {60, 0xaa31fbce1dad987d, 0xddd5cd129a9e6d6d},
+    };
+    if (shots.size() != frames.size()) {
+        printf("capture failed\n");
+        return 1;
+    }
+    for (auto i = std::size_t{}; i != shots.size(); ++i) {
+        if (shots[i].hash != pinned[i].hash) {
+            printf("frame %llu: %016llx %016llx\n", static_cast<unsigned long long>(shots[i].frame),
+                   static_cast<unsigned long long>(shots[i].hash),
+                   static_cast<unsigned long long>(shots[i].perceptual));
+        }
+        check(shots[i].hash == pinned[i].hash && shots[i].perceptual == pinned[i].perceptual, "pinned frame");
+    }
+    check(shots[0].hash != shots[1].hash && Golden::distance(shots[0].perceptual, shots[2].perceptual) > 0,
+          "frames differ");
+
+    // Manifest with two copies of the ROM, updated and checked again on several threads
+    auto const dir = std::filesystem::temp_directory_path() / "gb_golden_test";
+    std::filesystem::create_directories(dir);
+    for (auto const name : {"a.gb", "b.gb"}) {
+        std::ofstream(dir / name, std::ios::binary)
+            .write(reinterpret_cast<char const*>(rom.data()), static_cast<std::streamsize>(rom.size()));
+    }
+    std::ofstream(dir / "manifest.txt") << "# test\nb.gb 60 - -\na.gb 6 - -\na.gb 5 - -\nmissing.gb 1 - -\n";
+    auto golden = Golden{};
+    check(golden.load(dir / "manifest.txt") && golden.entries.size() == 4 && !golden.entries[0].known, "load");
+    auto failed = std::vector<std::string>{};
+    auto metrics = Metrics{};
+    auto const taken = golden.run(dir, 4, dir, failed, &metrics);
+    check(failed == std::vector<std::string>{"missing.gb"}, "missing rom");
+    auto single = Metrics{};
+    Golden::capture(rom.data(), rom.size(), {5, 6}, {}, PPU::Renderer::SCANLINE, &single);
+    Golden::capture(rom.data(), rom.size(), {60}, {}, PPU::Renderer::SCANLINE, &single);
+    check(metrics.instructions == single.instructions && metrics.cycles == single.cycles &&
+              single.cycles >= 66 * frame_cycles,
+          "summed metrics");
+    check(taken[0].hash == shots[2].hash && taken[1].hash == shots[1].hash && taken[2].hash == shots[0].hash,
+          "parallel run");
+    // Scanlines of 160 * 4 bytes plus a filter byte, stored as two deflate blocks
+    check(std::filesystem::file_size(dir / "a_6.png") == 8 + 25 + 12 + 2 + 10 + 641 * 144 + 4 + 12, "png written");
+    for (auto i = std::size_t{}; i != 3; ++i) {
+        golden.entries[i].expected = taken[i];
+        golden.entries[i].known = true;
+    }
+    check(golden.save(dir / "manifest.txt"), "save");
+    auto reloaded = Golden{};
+    check(reloaded.load(dir / "manifest.txt") && reloaded.entries.size() == 4 && reloaded.entries[0].known &&
+              reloaded.entries[0].expected.hash == shots[2].hash &&
+              reloaded.entries[2].expected.perceptual == shots[0].perceptual && !reloaded.entries[3].known,
+          "reload");
+    std::filesystem::remove_all(dir);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,135 @@
+// Cartridge header decoding and warnings, the ROM catalog round trip and the LY polling fast-forward, which has to
+// leave a machine exactly where stepping through every iteration would.
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <vector>
+
+#include "gb/boot.hpp"
+#include "gb/catalog.hpp"
+#include "gb/header.hpp"
+#include "gb/machine.hpp"
+#include "gb/save.hpp"
+#include "gb/state.hpp"
+
+using namespace gb;
+
+namespace {
+    int failures = 0;
+
+    auto check(bool condition, char const* what) -> void {
+        if (!condition) {
+            printf("%s failed\n", what);
+            ++failures;
+        }
+    }
+
+    /// Well formed MBC1 + RAM + battery cartridge with code at 0x150
+    template <std::size_t N>
+    auto build_rom(byte_t const (&code)[N]) -> std::vector<byte_t> {
+        auto rom = std::vector<byte_t>(0x8000);
+        byte_t const entry[] = {0x00, 0xC3, 0x50, 0x01};
+        std::copy(std::begin(entry), std::end(entry), rom.begin() + 0x100);
+        std::copy(Boot::logo.begin(), Boot::logo.end(), rom.begin() + 0x104);
+        std::copy_n("IDLE TEST", 9, rom.begin() + 0x134);
+        rom[0x147] = 0x03;
+        rom[0x149] = 0x02;
+        std::copy(std::begin(code), std::end(code), rom.begin() + 0x150);
+        auto checksum = byte_t{};
+        for (auto address = 0x134; address != 0x14D; ++address) {
+            checksum = static_cast<byte_t>(checksum - rom[address] - 1);
+        }
+        rom[0x14D] = checksum;
+        auto sum = word_t{};
+        for (auto const value : rom) {
+            sum = static_cast<word_t>(sum + value);
+        }
+        rom[0x14E] = static_cast<byte_t>(sum >> 8);
+        rom[0x14F] = static_cast<byte_t>(sum);
+        return rom;
+    }
+
+    /// Waits for LY == 144, LY != 144, LY < 80 and LY >= 80 in turn, then bumps BGP so frames differ
+    byte_t const polls[] = {
+        0xF0, 0x44, 0xFE, 0x90, 0x20, 0xFA, 0xF0, 0x44, 0xFE, 0x90, 0x28, 0xFA, 0xF0, 0x44, 0xFE,
+        0x50, 0x30, 0xFA, 0xF0, 0x44, 0xFE, 0x50, 0x38, 0xFA, 0x04, 0x78, 0xE0, 0x47, 0x18, 0xE2,
+    };
+
+    auto snapshot(Machine const& machine) -> std::vector<byte_t> {
+        auto state = std::vector<byte_t>(State::size(machine.cpu, machine.mem));
+        state.resize(State::save(machine.cpu, machine.mem, state.data(), state.size()));
+        return state;
+    }
+}
+
+int main() {
+    auto const rom = build_rom(polls);
+
+    auto header = Header::parse(rom.data(), rom.size());
+    check(header.present && header.title == "IDLE TEST", "title");
+    check(header.mapper == Header::Mapper::MBC1 && header.battery && !header.timer, "type");
+    check(header.rom_size == 0x8000 && header.ram_size == 0x2000, "sizes");
+    check(Save::ram_size(header) == 0x2000 && !header.cgb, "save size");
+    check(header.logo && header.header_checksum == header.header_expected, "header checksum");
+    check(header.global_checksum == header.global_expected, "global checksum");
+    check(header.problems(rom.size()).empty(), "no problems");
+    check(header.problems(0x10000).size() == 1, "size mismatch");
+    auto broken = rom;
+    broken[0x104] ^= 1;
+    broken[0x147] = 0x19;
+    header = Header::parse(broken.data(), broken.size());
+    check(!header.supported() && !header.logo && header.problems(broken.size()).size() == 4, "broken");
+    check(!Header::parse(rom.data(), 0x14F).present, "too short");
+    broken[0x143] = 0x80;
+    broken[0x149] = 0x03;
+    header = Header::parse(broken.data(), broken.size());
+    check(header.cgb && Save::ram_size(header) == Save::max_size, "cgb and large RAM");
+
+    // Same ROM stepped and fast-forwarded in slices that end in the middle of loops
+    auto const stepped = std::make_unique<Machine>();
+    auto const skipped = std::make_unique<Machine>();
+    check(stepped->load(rom.data(), rom.size()) && skipped->load(rom.data(), rom.size()), "load");
+    check(skipped->mem.idle_count == 4, "idle loops");
+    stepped->mem.idle_count = 0;
+    for (auto i = 0; i != 400; ++i) {
+        stepped->run(12345 + i * 7);
+        skipped->run(12345 + i * 7);
+    }
+    check(skipped->mem.metrics.idle_cycles > skipped->mem.cycles / 2, "skipped");
+    check(stepped->mem.metrics.idle_cycles == 0, "stepped");
+    check(stepped->mem.cycles == skipped->mem.cycles, "cycles");
+    check(stepped->cpu.reg_b == skipped->cpu.reg_b && stepped->cpu.reg_b > 50, "iterations");
+    check(stepped->mem.metrics.instructions == skipped->mem.metrics.instructions, "instructions");
+    check(stepped->mem.metrics.io_reads == skipped->mem.metrics.io_reads, "io reads");
+    check(stepped->mem.ppu.framebuffer == skipped->mem.ppu.framebuffer, "framebuffer");
+    check(snapshot(*stepped) == snapshot(*skipped), "state");
+
+    auto oversize = std::vector<byte_t>(skipped->mem.ROM.size() + 1);
+    check(!std::make_unique<Machine>()->load(oversize.data(), oversize.size()), "oversize");
+
+    // First sight scans and adds, a reloaded catalog hands the loops back without a scan
+    auto const path = std::filesystem::temp_directory_path() / "gb_catalog_test.txt";
+    std::filesystem::remove(path);
+    auto catalog = Catalog{};
+    check(catalog.load(path) && catalog.entries.empty(), "missing file");
+    auto& added = catalog.attach(skipped->mem, rom.size());
+    check(catalog.changed && added.idle_loops.size() == 4 && added.title == "IDLE TEST", "add");
+    added.renderer = PPU::Renderer::FIFO;
+    check(catalog.save(path), "save");
+    auto reloaded = Catalog{};
+    check(reloaded.load(path) && reloaded.entries.size() == 1 && !reloaded.changed, "reload");
+    skipped->mem.idle_count = 0;
+    auto const& found = reloaded.attach(skipped->mem, rom.size());
+    check(!reloaded.changed && found.renderer == PPU::Renderer::FIFO && found.title == "IDLE TEST", "hit");
+    check(skipped->mem.idle_count == 4 && found.idle_loops == added.idle_loops, "cached loops");
+    reloaded.attach(skipped->mem, rom.size() - 1);
+    check(reloaded.changed && reloaded.entries.size() == 2, "other size");
+    std::ofstream(path) << "0123 32768 dots -\n";
+    check(!reloaded.load(path), "bad renderer");
+    std::ofstream(path) << "0123 32768 - 10000\n";
+    check(!reloaded.load(path), "bad address");
+    std::filesystem::remove(path);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,157 @@
+#pragma once
+#include <charconv>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/// Small JSON reader, just enough for test vector files
+namespace gb::json {
+    struct Value {
+        enum class Kind : std::uint8_t { NUL, BOOL, NUMBER, STRING, ARRAY, OBJECT };
+
+        Kind kind = Kind::NUL;
+        bool boolean = {};
+        std::int64_t number = {};
+        std::string string = {};
+        std::vector<Value> items = {};
+        std::vector<std::pair<std::string, Value>> members = {};
+
+        auto is_null() const noexcept -> bool { return kind == Kind::NUL; }
+
+        auto operator[](std::size_t index) const noexcept -> Value const& { return items[index]; }
+
+        auto find(std::string_view key) const noexcept -> Value const* {
+            for (auto const& [name, value] : members) {
+                if (name == key) {
+                    return &value;
+                }
+            }
+            return nullptr;
+        }
+
+        auto integer(std::string_view key, std::int64_t fallback = 0) const noexcept -> std::int64_t {
+            auto const value = find(key);
+            return value && value->kind == Kind::NUMBER ? value->number : fallback;
+        }
+    };
+
+    struct Parser {
+        char const* cur;
+        char const* end;
+        std::string error = {};
+
+        auto skip() noexcept -> void {
+            while (cur != end && (*cur == ' ' || *cur == '\n' || *cur == '\r' || *cur == '\t')) {
+                ++cur;
+            }
+        }
+
+        auto fail(char const* message) -> bool {
+            if (error.empty()) {
+                error = message;
+            }
+            return false;
+        }
+
+        auto expect(char c) -> bool {
+            skip();
+            if (cur == end || *cur != c) {
+                return fail("Unexpected character!");
+            }
+            ++cur;
+            return true;
+        }
+
+        auto literal(std::string_view text) -> bool {
+            if (static_cast<std::size_t>(end - cur) < text.size() || std::string_view(cur, text.size()) != text) {
+                return fail("Bad literal!");
+            }
+            cur += text.size();
+            return true;
+        }
+
+        auto parse_string(std::string& out) -> bool {
+            if (!expect('"')) {
+                return false;
+            }
+            while (cur != end && *cur != '"') {
+                if (*cur == '\\' && cur + 1 != end) {
+                    ++cur;
+                }
+                out.push_back(*cur++);
+            }
+            return expect('"');
+        }
+
+        auto parse(Value& out) -> bool {
+            skip();
+            if (cur == end) {
+                return fail("Unexpected end!");
+            }
+            switch (*cur) {
+                case 'n':
+                    out.kind = Value::Kind::NUL;
+                    return literal("null");
+                case 't':
+                    out.kind = Value::Kind::BOOL;
+                    out.boolean = true;
+                    return literal("true");
+                case 'f':
+                    out.kind = Value::Kind::BOOL;
+                    return literal("false");
+                case '"':
+                    out.kind = Value::Kind::STRING;
+                    return parse_string(out.string);
+                case '[':
+                    out.kind = Value::Kind::ARRAY;
+                    ++cur;
+                    skip();
+                    if (cur != end && *cur == ']') {
+                        ++cur;
+                        return true;
+                    }
+                    do {
+                        if (!parse(out.items.emplace_back())) {
+                            return false;
+                        }
+                        skip();
+                    } while (cur != end && *cur == ',' && ++cur);
+                    return expect(']');
+                case '{':
+                    out.kind = Value::Kind::OBJECT;
+                    ++cur;
+                    skip();
+                    if (cur != end && *cur == '}') {
+                        ++cur;
+                        return true;
+                    }
+                    do {
+                        auto& member = out.members.emplace_back();
+                        if (!parse_string(member.first) || !expect(':') || !parse(member.second)) {
+                            return false;
+                        }
+                        skip();
+                    } while (cur != end && *cur == ',' && ++cur);
+                    return expect('}');
+                default: {
+                    out.kind = Value::Kind::NUMBER;
+                    auto const [ptr, ec] = std::from_chars(cur, end, out.number);
+                    if (ec != std::errc{}) {
+                        return fail("Bad number!");
+                    }
+                    cur = ptr;
+                    return true;
+                }
+            }
+        }
+    };
+
+    inline auto parse(std::string_view text, Value& out, std::string& error) -> bool {
+        auto parser = Parser{text.data(), text.data() + text.size()};
+        auto const result = parser.parse(out);
+        error = parser.error;
+        return result;
+    }
+}
@@ -0,0 +1,89 @@
+// Checks every kernel variant the host supports against the scalar reference, bit for bit.
+// Sizes around every vector width and misaligned starts exercise the main loops and all tails.
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "gb/kernels.hpp"
+
+using namespace gb;
+
+namespace {
+    int failures = 0;
+
+    auto check(bool condition, char const* name, char const* what, std::size_t size, std::size_t offset) -> void {
+        if (!condition) {
+            printf("%s: %s differs, size %zu, offset %zu\n", name, what, size, offset);
+            ++failures;
+        }
+    }
+
+    auto test(Kernels const& k, Kernels const& ref, std::mt19937_64& rng) -> void {
+        auto bytes = [&](std::size_t size) {
+            auto data = std::vector<byte_t>(size);
+            for (auto& value : data) {
+                value = static_cast<byte_t>(rng());
+            }
+            return data;
+        };
+        for (auto size = std::size_t{}; size != 300; ++size) {
+            for (auto offset = std::size_t{}; offset != 3; ++offset) {
+                auto const a = bytes(size + offset);
+                auto b = a;
+                if (size) {
+                    b[offset + rng() % size] ^= static_cast<byte_t>(1 + rng() % 255);
+                }
+                auto const seed = rng();
+                check(k.hash(a.data() + offset, size, seed) == ref.hash(a.data() + offset, size, seed), k.name,
+                      "hash", size, offset);
+
+                auto out = std::vector<byte_t>(size + 1, 0xAA);
+                auto out_ref = out;
+                check(k.xor_delta(out.data() + 1, a.data() + offset, b.data() + offset, size) ==
+                              ref.xor_delta(out_ref.data() + 1, a.data() + offset, b.data() + offset, size) &&
+                          out == out_ref,
+                      k.name, "xor_delta", size, offset);
+                check(!k.xor_delta(out.data() + 1, a.data() + offset, a.data() + offset, size), k.name,
+                      "xor_delta equal", size, offset);
+            }
+        }
+
+        // Hash blocks are 1 KiB, cover several with every tail length
+        for (auto size : {1023u, 1024u, 1025u, 4096u + 17u, 65536u + 63u}) {
+            auto const data = bytes(size);
+            check(k.hash(data.data(), size, 7) == ref.hash(data.data(), size, 7), k.name, "hash", size, 0);
+        }
+
+        for (auto count = std::size_t{}; count != 20; ++count) {
+            auto pixels = std::vector<std::uint32_t>(count * 3);
+            for (auto& pixel : pixels) {
+                pixel = static_cast<std::uint32_t>(rng());
+            }
+            auto rgba = std::vector<byte_t>(pixels.size() * 4);
+            auto rgba_ref = rgba;
+            k.to_rgba(pixels.data(), pixels.size(), rgba.data());
+            ref.to_rgba(pixels.data(), pixels.size(), rgba_ref.data());
+            check(rgba == rgba_ref, k.name, "to_rgba", pixels.size(), 0);
+        }
+    }
+}
+
+int main() {
+    auto const& ref = *Kernels::get(Kernels::ISA::SCALAR);
+
+    // Known answers pin the scalar reference itself
+    std::uint32_t const argb = 0x80112233;
+    byte_t rgba[4] = {};
+    ref.to_rgba(&argb, 1, rgba);
+    check(rgba[0] == 0x11 && rgba[1] == 0x22 && rgba[2] == 0x33 && rgba[3] == 0x80, ref.name, "to_rgba reference", 1, 0);
+
+    auto rng = std::mt19937_64{1};
+    for (auto isa : {Kernels::ISA::SSE2, Kernels::ISA::AVX2, Kernels::ISA::AVX512}) {
+        if (auto const k = Kernels::get(isa)) {
+            test(*k, ref, rng);
+            printf("%s: checked\n", k->name);
+        }
+    }
+    printf("best: %s\n", Kernels::best().name);
+    return failures ? 1 : 0;
+}
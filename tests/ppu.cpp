@@ -0,0 +1,126 @@
+// Both renderers on generated ROMs. A still scene with fine scrolling, the window and clipped, overlapping 8 x 16
+// sprites has to come out the same from either one, palette writes in the middle of lines only show up with the pixel
+// FIFO. Also covers the compatibility database.
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <vector>
+
+#include "gb/compat.hpp"
+#include "gb/golden.hpp"
+#include "gb/machine.hpp"
+
+using namespace gb;
+
+namespace {
+    int failures = 0;
+
+    auto check(bool condition, char const* what) -> void {
+        if (!condition) {
+            printf("%s failed\n", what);
+            ++failures;
+        }
+    }
+
+    template <std::size_t N>
+    auto build_rom(byte_t const (&code)[N]) -> std::vector<byte_t> {
+        auto rom = std::vector<byte_t>(0x8000);
+        byte_t const entry[] = {0x00, 0xC3, 0x50, 0x01};
+        std::copy(std::begin(entry), std::end(entry), rom.begin() + 0x100);
+        std::copy(std::begin(code), std::end(code), rom.begin() + 0x150);
+        return rom;
+    }
+
+    /// Fills tiles and both maps with the LCD off, places 40 sprites from X = 2 on and then spins
+    byte_t const still[] = {
+        // LCD off, 0x8000 - 0x97FF = L ^ H, 0x9800 - 0x9FFF = L + H
+        0xAF, 0xE0, 0x40, 0x21, 0x00, 0x80, 0x7D, 0xAC, 0x22, 0x7C, 0xFE, 0x98, 0x20, 0xF8, 0x7D, 0x84, 0x22,
+        0x7C, 0xFE, 0xA0, 0x20, 0xF8,
+        // Sprite c at Y = 3c + 16, X = 4c + 2, tile c, flips and palette from c << 3
+        0x21, 0x00, 0xFE, 0x0E, 0x00, 0x79, 0x87, 0x81, 0xC6, 0x10, 0x22, 0x79, 0x87, 0x87, 0xC6, 0x02, 0x22,
+        0x79, 0x22, 0x79, 0x07, 0x07, 0x07, 0xE6, 0x70, 0x22, 0x0C, 0x79, 0xFE, 0x28, 0x20, 0xE5,
+        // SCX = 3, SCY = 5, WX = 50, WY = 40, palettes, LCD on with window, 8 x 16 sprites and background
+        0x3E, 0x03, 0xE0, 0x43, 0x3E, 0x05, 0xE0, 0x42, 0x3E, 0x32, 0xE0, 0x4B, 0x3E, 0x28, 0xE0, 0x4A, 0x3E,
+        0xE4, 0xE0, 0x47, 0x3E, 0xD2, 0xE0, 0x48, 0x3E, 0x1E, 0xE0, 0x49, 0x3E, 0xF7, 0xE0, 0x40, 0x18, 0xFE,
+    };
+
+    /// Swaps BGP between 0xE4 and 0x1B every 52 dots, several times within each line
+    byte_t const raster[] = {0x3E, 0xE4, 0xE0, 0x47, 0x3E, 0x1B, 0xE0, 0x47, 0x18, 0xF6};
+
+    /// Lines among the first 16 that are not a single color, the boot logo is further down
+    auto mixed_lines(std::vector<byte_t> const& rom, PPU::Renderer renderer) -> int {
+        auto const machine = std::make_unique<Machine>();
+        machine->mem.ppu.renderer = renderer;
+        machine->load(rom.data(), rom.size());
+        machine->run(3 * frame_cycles);
+        auto const& frame = machine->mem.ppu.framebuffer;
+        auto mixed = 0;
+        for (auto y = 0; y != 16; ++y) {
+            auto const row = frame.begin() + y * PPU::width;
+            mixed += std::any_of(row, row + PPU::width, [&](auto pixel) { return pixel != row[0]; });
+        }
+        return mixed;
+    }
+}
+
+int main() {
+    auto const rom = build_rom(still);
+    std::vector<std::uint64_t> const frames = {10, 11};
+    auto const scanline = Golden::capture(rom.data(), rom.size(), frames);
+    auto const fifo = Golden::capture(rom.data(), rom.size(), frames, {}, PPU::Renderer::FIFO);
+    check(scanline.size() == 2 && fifo.size() == 2, "capture");
+    for (auto i = std::size_t{}; i != std::min(scanline.size(), fifo.size()); ++i) {
+        check(scanline[i].hash == fifo[i].hash, "same still frame");
+    }
+    check(scanline[0].hash == scanline[1].hash, "still");
+
+    check(mixed_lines(build_rom(raster), PPU::Renderer::SCANLINE) == 0, "scanline raster");
+    check(mixed_lines(build_rom(raster), PPU::Renderer::FIFO) == 16, "fifo raster");
+
+    // Switching away in the middle of a line and back must not pick up the abandoned line's FIFO state
+    auto const stayed = std::make_unique<Machine>();
+    auto const switched = std::make_unique<Machine>();
+    auto const raster_rom = build_rom(raster);
+    for (auto& machine : {stayed.get(), switched.get()}) {
+        machine->mem.ppu.renderer = PPU::Renderer::FIFO;
+        machine->load(raster_rom.data(), raster_rom.size());
+        machine->run(frame_cycles + 10 * PPU::line_cycles + 200);
+    }
+    switched->mem.video_sync();
+    switched->mem.ppu.set_renderer(PPU::Renderer::SCANLINE);
+    check(switched->mem.ppu.fifo.dot == 0, "switch resets fifo");
+    stayed->run(3 * PPU::line_cycles + 10);
+    switched->run(3 * PPU::line_cycles + 10);
+    switched->mem.video_sync();
+    switched->mem.ppu.set_renderer(PPU::Renderer::FIFO);
+    stayed->run(2 * frame_cycles);
+    switched->run(2 * frame_cycles);
+    check(stayed->mem.ppu.framebuffer == switched->mem.ppu.framebuffer, "switch back");
+
+    // Exact global checksum first, then any global checksum, then the scanline renderer
+    auto const path = std::filesystem::temp_directory_path() / "gb_compat_test.txt";
+    std::ofstream(path) << "# header global renderer\n4D - fifo\n4d 1234 scanline # two carts\n\n";
+    auto compat = Compat{};
+    check(compat.load(path) && compat.entries.size() == 2 && !compat.entries[0].global_checksum, "load");
+    auto cart = std::vector<byte_t>(0x150);
+    cart[0x14D] = 0x4D;
+    check(compat.renderer(cart.data(), cart.size()) == PPU::Renderer::FIFO, "header match");
+    cart[0x14E] = 0x12;
+    cart[0x14F] = 0x34;
+    check(compat.renderer(cart.data(), cart.size()) == PPU::Renderer::SCANLINE, "global match");
+    cart[0x14D] = 0x4E;
+    check(compat.renderer(cart.data(), cart.size()) == PPU::Renderer::SCANLINE, "unlisted");
+    check(compat.renderer(cart.data(), 0x100) == PPU::Renderer::SCANLINE, "no header");
+    compat.forced = Compat::parse("fifo");
+    check(compat.renderer(cart.data(), cart.size()) == PPU::Renderer::FIFO, "forced");
+    check(compat.listed(cart.data(), cart.size()) == PPU::Renderer::SCANLINE, "listed ignores forced");
+    check(!Compat::parse("dots"), "parse");
+    std::ofstream(path) << "4D - dots\n";
+    check(!compat.load(path), "bad renderer");
+    std::ofstream(path) << "14D - fifo\n";
+    check(!compat.load(path), "bad checksum");
+    std::filesystem::remove(path);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,97 @@
+// Small programs run to completion at compile time, a failing check breaks the build of gb_tests.
+#include "gb/cpu.hpp"
+#include "gb/cpu_alu.hpp"
+#include "gb/cpu_flat.hpp"
+
+using namespace gb;
+
+namespace {
+    using Status = CPU::Status;
+
+    /// Sum of 1 to 10 in a counted loop
+    constexpr byte_t sum[] = {
+        0xAF,        // 0100 XOR A
+        0x06, 0x0A,  // 0101 LD B, 10
+        0x80,        // 0103 ADD A, B
+        0x05,        // 0104 DEC B
+        0x20, 0xFC,  // 0105 JR NZ, $0103
+        0x76,        // 0107 HALT
+    };
+    constexpr auto sum_run = CPU::FLAT::execute(sum);
+    static_assert(sum_run.status == Status::HALT && sum_run.cpu.reg_a == 55 && sum_run.cpu.reg_b == 0);
+    static_assert(sum_run.cpu.reg_ip == 0x108 && sum_run.cycles == 53);
+
+    /// BCD counter, 37 increments adjusted with DAA
+    constexpr byte_t bcd[] = {
+        0xAF,        // 0100 XOR A
+        0x06, 0x25,  // 0101 LD B, 37
+        0xC6, 0x01,  // 0103 ADD A, 1
+        0x27,        // 0105 DAA
+        0x05,        // 0106 DEC B
+        0x20, 0xFA,  // 0107 JR NZ, $0103
+        0x76,        // 0109 HALT
+    };
+    constexpr auto bcd_run = CPU::FLAT::execute(bcd);
+    static_assert(bcd_run.status == Status::HALT && bcd_run.cpu.reg_a == 0x37 && !bcd_run.cpu.reg_f.carry);
+
+    /// First ten Fibonacci numbers stored from $C000
+    constexpr byte_t fibonacci[] = {
+        0x21, 0x00, 0xC0,  // 0100 LD HL, $C000
+        0x3E, 0x01,        // 0103 LD A, 1
+        0x06, 0x00,        // 0105 LD B, 0
+        0x0E, 0x0A,        // 0107 LD C, 10
+        0x22,              // 0109 LD (HL+), A
+        0x57,              // 010A LD D, A
+        0x80,              // 010B ADD A, B
+        0x42,              // 010C LD B, D
+        0x0D,              // 010D DEC C
+        0x20, 0xF9,        // 010E JR NZ, $0109
+        0x76,              // 0110 HALT
+    };
+    constexpr auto fibonacci_run = CPU::FLAT::execute(fibonacci);
+    static_assert([] {
+        constexpr byte_t expected[] = {1, 1, 2, 3, 5, 8, 13, 21, 34, 55};
+        for (auto i = 0; i != 10; ++i) {
+            if (fibonacci_run.memory[0xC000 + i] != expected[i]) {
+                return false;
+            }
+        }
+        return fibonacci_run.memory[0xC00A] == 0 && fibonacci_run.cpu.reg_l == 0x0A;
+    }());
+
+    /// Subroutine that saves AF around a prefixed op
+    constexpr byte_t call[] = {
+        0x3E, 0x12,        // 0100 LD A, $12
+        0xCD, 0x08, 0x01,  // 0102 CALL $0108
+        0x47,              // 0105 LD B, A
+        0x76,              // 0106 HALT
+        0x00,              // 0107 NOP
+        0xF5,              // 0108 PUSH AF
+        0xCB, 0x37,        // 0109 SWAP A
+        0x4F,              // 010B LD C, A
+        0xF1,              // 010C POP AF
+        0xC9,              // 010D RET
+    };
+    constexpr auto call_run = CPU::FLAT::execute(call);
+    static_assert(call_run.status == Status::HALT && call_run.cpu.reg_sp == 0xFFFE);
+    static_assert(call_run.cpu.reg_a == 0x12 && call_run.cpu.reg_b == 0x12 && call_run.cpu.reg_c == 0x21);
+    static_assert(call_run.memory[0xFFFD] == 0x01 && call_run.memory[0xFFFC] == 0x05);
+
+    /// Lookup tables agree with the ops they were built from for every input, whether or not the build uses them
+    template <auto OP>
+    constexpr auto table_matches() -> bool {
+        for (auto index = std::size_t{}; index != 16 * 256; ++index) {
+            auto const flags = CPU::Flags::from_byte(static_cast<byte_t>(index >> 8 << 4));
+            auto const lhs = static_cast<byte_t>(index & 0xFF);
+            auto const expected = OP(flags, lhs);
+            auto const actual = CPU::ALU::lookup_result<OP>(flags, lhs);
+            if (actual.value != expected.value || actual.flags != expected.flags) {
+                return false;
+            }
+        }
+        return true;
+    }
+    static_assert(table_matches<&CPU::ALU::op_misc_inc>());
+    static_assert(table_matches<&CPU::ALU::op_misc_dec>());
+    static_assert(table_matches<&CPU::ALU::op_misc_daa>());
+}
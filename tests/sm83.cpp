@@ -0,0 +1,228 @@
+// Per-opcode differential test against SM83 single step test vectors.
+// Usage: gb_tests <dir>, where dir holds "xx.json" and "cb xx.json" files in the widely published format.
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#include "gb/cpu.hpp"
+#include "gb/cpu_exe.hpp"
+#include "json.hpp"
+
+using namespace gb;
+
+namespace {
+    constexpr int exit_skip = 77;
+
+    struct Access {
+        enum class Kind : byte_t { READ, WRITE, WASTE };
+
+        Kind kind = {};
+        word_t address = {};
+        byte_t value = {};
+
+        bool operator==(Access const&) const noexcept = default;
+    };
+
+    /// Flat 64K bus that records every memory cycle
+    struct TestBus final : CPU::BUS {
+        std::array<byte_t, 0x10000> memory = {};
+        std::vector<Access> log = {};
+
+        gb_func virtual read_byte(word_t address) noexcept->byte_t override {
+            log.push_back({Access::Kind::READ, address, memory[address]});
+            return memory[address];
+        }
+
+        gb_func virtual write_byte(word_t address, byte_t value) noexcept->void override {
+            log.push_back({Access::Kind::WRITE, address, value});
+            memory[address] = value;
+        }
+
+        gb_func virtual waste() noexcept->void override { log.push_back({Access::Kind::WASTE}); }
+    };
+
+    auto load_state(json::Value const& state, CPU& cpu, TestBus& bus) -> void {
+        cpu.reg_a = static_cast<byte_t>(state.integer("a"));
+        cpu.reg_b = static_cast<byte_t>(state.integer("b"));
+        cpu.reg_c = static_cast<byte_t>(state.integer("c"));
+        cpu.reg_d = static_cast<byte_t>(state.integer("d"));
+        cpu.reg_e = static_cast<byte_t>(state.integer("e"));
+        cpu.reg_h = static_cast<byte_t>(state.integer("h"));
+        cpu.reg_l = static_cast<byte_t>(state.integer("l"));
+        cpu.reg_f = CPU::Flags::from_byte(static_cast<byte_t>(state.integer("f")));
+        cpu.reg_sp = static_cast<word_t>(state.integer("sp"));
+        cpu.reg_ip = static_cast<word_t>(state.integer("pc"));
+        cpu.reg_ime = state.integer("ime") != 0;
+        if (auto const ram = state.find("ram")) {
+            for (auto const& cell : ram->items) {
+                bus.memory[static_cast<word_t>(cell[0].number)] = static_cast<byte_t>(cell[1].number);
+            }
+        }
+    }
+
+    /// Returns empty string on success, otherwise description of the first mismatch
+    auto run_test(json::Value const& test, TestBus& bus) -> std::string {
+        auto const initial = test.find("initial");
+        auto const final = test.find("final");
+        if (!initial || !final) {
+            return "malformed test";
+        }
+        auto cpu = CPU{};
+        load_state(*initial, cpu, bus);
+        bus.log.clear();
+        CPU::EXE::step(cpu, bus);
+
+        auto out = std::ostringstream{};
+        out << std::hex;
+        auto const check = [&](char const* name, std::int64_t actual) {
+            if (auto const expected = final->integer(name, -1); expected != -1 && expected != actual) {
+                out << name << ": expected " << expected << " got " << actual << "; ";
+            }
+        };
+        check("a", cpu.reg_a);
+        check("b", cpu.reg_b);
+        check("c", cpu.reg_c);
+        check("d", cpu.reg_d);
+        check("e", cpu.reg_e);
+        check("f", cpu.reg_f.into_byte());
+        check("h", cpu.reg_h);
+        check("l", cpu.reg_l);
+        check("sp", cpu.reg_sp);
+        check("pc", cpu.reg_ip);
+        check("ime", cpu.reg_ime);
+        if (auto const ram = final->find("ram")) {
+            for (auto const& cell : ram->items) {
+                auto const address = static_cast<word_t>(cell[0].number);
+                if (bus.memory[address] != cell[1].number) {
+                    out << "ram[" << address << "]: expected " << cell[1].number << " got " << +bus.memory[address]
+                        << "; ";
+                }
+            }
+        }
+        if (auto const cycles = test.find("cycles")) {
+            auto expected = std::vector<Access>{};
+            for (auto const& cycle : cycles->items) {
+                // Internal cycles are either null or carry "---" pins, their address is not compared
+                auto const pins = cycle.items.size() == 3 ? std::string_view(cycle[2].string) : std::string_view{};
+                if (cycle.is_null() || (pins.find('r') == pins.npos && pins.find('w') == pins.npos)) {
+                    expected.push_back({Access::Kind::WASTE});
+                } else {
+                    auto const kind = pins.find('w') != pins.npos ? Access::Kind::WRITE : Access::Kind::READ;
+                    expected.push_back(
+                        {kind, static_cast<word_t>(cycle[0].number), static_cast<byte_t>(cycle[1].number)});
+                }
+            }
+            if (expected != bus.log) {
+                out << "bus: expected " << expected.size() << " cycles got " << bus.log.size() << " [";
+                for (auto const& access : bus.log) {
+                    out << " " << "rw-"[static_cast<int>(access.kind)] << access.address << "=" << +access.value;
+                }
+                out << " ]; ";
+            }
+        }
+
+        // Restore memory so the next test starts from a clean bus
+        for (auto const& access : bus.log) {
+            bus.memory[access.address] = 0;
+        }
+        if (auto const ram = initial->find("ram")) {
+            for (auto const& cell : ram->items) {
+                bus.memory[static_cast<word_t>(cell[0].number)] = 0;
+            }
+        }
+        return out.str();
+    }
+
+    struct Result {
+        std::string file = {};
+        std::size_t passed = {};
+        std::size_t failed = {};
+        std::string first_failure = {};
+    };
+
+    auto run_file(std::filesystem::path const& path, TestBus& bus) -> Result {
+        auto result = Result{path.filename().string()};
+        auto file = std::ifstream(path, std::ios::binary);
+        auto const text = std::string(std::istreambuf_iterator<char>(file), {});
+        auto root = json::Value{};
+        auto error = std::string{};
+        if (!json::parse(text, root, error)) {
+            result.failed = 1;
+            result.first_failure = "parse error: " + error;
+            return result;
+        }
+        for (auto const& test : root.items) {
+            if (auto message = run_test(test, bus); message.empty()) {
+                ++result.passed;
+            } else {
+                if (result.failed++ == 0) {
+                    auto const name = test.find("name");
+                    result.first_failure = (name ? name->string : std::string{"?"}) + ": " + message;
+                }
+            }
+        }
+        return result;
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        printf("Usage: %s <sm83 test vector directory>\n", argv[0]);
+        return 1;
+    }
+    auto const directory = std::filesystem::path(argv[1]);
+
+    // Every slot of both dispatch tables gets its own file, missing files are simply not covered
+    auto files = std::vector<std::filesystem::path>{};
+    char name[16];
+    for (int op = 0; op != 256; ++op) {
+        snprintf(name, sizeof(name), "%02x.json", op);
+        if (std::filesystem::exists(directory / name)) {
+            files.push_back(directory / name);
+        }
+        snprintf(name, sizeof(name), "cb %02x.json", op);
+        if (std::filesystem::exists(directory / name)) {
+            files.push_back(directory / name);
+        }
+    }
+    if (files.empty()) {
+        printf("No test vectors found in %s\n", directory.string().c_str());
+        return exit_skip;
+    }
+
+    auto results = std::vector<Result>(files.size());
+    auto next = std::atomic<std::size_t>{};
+    auto const worker = [&] {
+        auto bus = std::make_unique<TestBus>();
+        for (auto i = next++; i < files.size(); i = next++) {
+            results[i] = run_file(files[i], *bus);
+        }
+    };
+    auto threads = std::vector<std::thread>{};
+    auto const count = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned i = 0; i != count; ++i) {
+        threads.emplace_back(worker);
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    auto passed = std::size_t{};
+    auto failed = std::size_t{};
+    for (auto const& result : results) {
+        passed += result.passed;
+        failed += result.failed;
+        if (result.failed) {
+            printf("FAIL %s (%zu/%zu): %s\n",
+                   result.file.c_str(),
+                   result.failed,
+                   result.passed + result.failed,
+                   result.first_failure.c_str());
+        }
+    }
+    printf("%zu files, %zu passed, %zu failed\n", files.size(), passed, failed);
+    return failed ? 1 : 0;
+}